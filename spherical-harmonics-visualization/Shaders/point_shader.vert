@@ -0,0 +1,64 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : require
+
+// Per-vertex data of the point model, compiled with COMPACT_VERTEX for the compact vertex layouts of VvtModel
+#ifdef COMPACT_VERTEX
+layout(location = 0) in vec3 position;
+layout(location = 2) in vec2 octahedralNormal;
+
+// Inverse of the octahedral encoding in VvtModel::VertexLayout::encode
+vec3 decodeNormal() {
+  vec3 n = vec3(octahedralNormal, 1.0 - abs(octahedralNormal.x) - abs(octahedralNormal.y));
+  if (n.z < 0.0) {
+    n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  }
+  return n;
+}
+#else
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec2 uv;
+
+vec3 decodeNormal() {
+  return normal;
+}
+#endif
+
+// Per-instance data of a sample point
+layout(location = 4) in vec3 instancePosition;
+layout(location = 5) in float instanceValue;
+
+layout(location = 0) out vec3 fragColor;
+
+// Specialization constants, see SimpleRenderSystem::PointStyle. SH_ORDER and COLOR_MODE are declared in sh_common.glsl
+#include "sh_common.glsl"
+layout(constant_id = 2) const bool LIGHTING = true;
+
+layout (set=0, binding = 0) uniform UBO 
+{
+  mat4 projectionMatrix;
+  vec3 directionToLight;
+  mat4 view;
+} ubo;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+  float colorScale;
+  float pointScale;
+} push;
+
+const float AMBIENT = 0.02;
+
+void main() {
+  // The point model is only scaled, so its normals don't need a normal matrix
+  vec3 worldPosition = (push.modelMatrix * vec4(instancePosition, 1.0)).xyz + push.pointScale * position;
+  gl_Position = ubo.projectionMatrix * ubo.view * vec4(worldPosition, 1.0);
+
+  // If light intensity is negative(surface isn't facing light), the intensity should be 0
+  float lightIntensity = LIGHTING ? AMBIENT + max(dot(normalize(decodeNormal()), ubo.directionToLight), 0) : 1.0;
+
+  fragColor = lightIntensity * valueColor(instanceValue, push.colorScale);
+}
@@ -0,0 +1,76 @@
+// Evaluation and colouring of spherical functions, shared by the point, reconstruction and surface shaders
+#ifndef SH_COMMON_GLSL
+#define SH_COMMON_GLSL
+
+// Specialization constants, see SimpleRenderSystem::PointStyle
+layout(constant_id = 0) const int SH_ORDER = 3;	// Highest band of the reconstruction, at most 3
+layout(constant_id = 1) const int COLOR_MODE = 0;	// 0: signed red/blue, 1: turbo colour map
+
+// Real SH basis functions (with Condon-Shortley phase, as in sh::EvalSH) of a unit direction, up to band SH_ORDER.
+// The order is a constant when the pipeline is created, so the unused bands and the loop disappear.
+// coeffs holds the coefficients up to order 3, indexed by l(l+1)+m
+float evalSHSum(vec3 d, vec4 coeffs[4]) {
+  float x = d.x, y = d.y, z = d.z;
+  float x2 = x * x, y2 = y * y, z2 = z * z;
+
+  float basis[16];
+  basis[0] = 0.282095;
+  if (SH_ORDER >= 1) {
+    basis[1] = -0.488603 * y;
+    basis[2] = 0.488603 * z;
+    basis[3] = -0.488603 * x;
+  }
+  if (SH_ORDER >= 2) {
+    basis[4] = 1.092548 * x * y;
+    basis[5] = -1.092548 * y * z;
+    basis[6] = 0.315392 * (3.0 * z2 - 1.0);
+    basis[7] = -1.092548 * x * z;
+    basis[8] = 0.546274 * (x2 - y2);
+  }
+  if (SH_ORDER >= 3) {
+    basis[9] = -0.590044 * y * (3.0 * x2 - y2);
+    basis[10] = 2.890611 * x * y * z;
+    basis[11] = -0.457046 * y * (4.0 * z2 - x2 - y2);
+    basis[12] = 0.373176 * z * (2.0 * z2 - 3.0 * x2 - 3.0 * y2);
+    basis[13] = -0.457046 * x * (4.0 * z2 - x2 - y2);
+    basis[14] = 1.445306 * z * (x2 - y2);
+    basis[15] = -0.590044 * x * (x2 - 3.0 * y2);
+  }
+
+  float sum = 0.0;
+  for (int i = 0; i < (SH_ORDER + 1) * (SH_ORDER + 1); i++) {
+    sum += basis[i] * coeffs[i / 4][i % 4];
+  }
+  return sum;
+}
+
+// Polynomial approximation of the turbo colour map, t in [0, 1]
+vec3 turbo(float t) {
+  const vec4 redVec4 = vec4(0.13572138, 4.61539260, -42.66032258, 132.13108234);
+  const vec4 greenVec4 = vec4(0.09140261, 2.19418839, 4.84296658, -14.18503333);
+  const vec4 blueVec4 = vec4(0.10667330, 12.64194608, -60.58204836, 110.36276771);
+  const vec2 redVec2 = vec2(-152.94239396, 59.28637943);
+  const vec2 greenVec2 = vec2(4.27729857, 2.82956604);
+  const vec2 blueVec2 = vec2(-89.90310912, 27.34824973);
+
+  t = clamp(t, 0.0, 1.0);
+  vec4 v4 = vec4(1.0, t, t * t, t * t * t);
+  vec2 v2 = v4.zw * v4.z;
+  return vec3(
+    dot(v4, redVec4) + dot(v2, redVec2),
+    dot(v4, greenVec4) + dot(v2, greenVec2),
+    dot(v4, blueVec4) + dot(v2, blueVec2));
+}
+
+vec3 valueColor(float value, float colorScale) {
+  if (COLOR_MODE == 1) {
+    // Scaled values in [-1, 1] span the whole colour map
+    return turbo(0.5 + 0.5 * colorScale * value);
+  }
+
+  // Positive values are red, negative values are blue
+  float intensity = colorScale * abs(value);
+  return value < 0.0 ? vec3(0.0, 0.0, intensity) : vec3(intensity, 0.0, 0.0);
+}
+
+#endif
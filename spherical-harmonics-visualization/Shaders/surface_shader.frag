@@ -0,0 +1,31 @@
+#version 450
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragWorldPosition;
+layout(location = 2) in vec3 fragOutward;
+layout(location = 3) flat in vec3 fragDirectionToLight;
+
+layout (location = 0) out vec4 outColor;
+
+// Specialization constants, see SimpleRenderSystem::PointStyle
+layout(constant_id = 2) const bool LIGHTING = true;
+
+const float AMBIENT = 0.02;
+
+void main() {
+  if (!LIGHTING) {
+    outColor = vec4(fragColor, 1.0);
+    return;
+  }
+
+  // The displaced surface has no vertex normals, the face normal follows from the screen space derivatives.
+  // Its sign depends on the winding on screen, so it is flipped to point away from the center of the sphere
+  vec3 normal = normalize(cross(dFdx(fragWorldPosition), dFdy(fragWorldPosition)));
+  if (dot(normal, fragOutward) < 0.0) {
+    normal = -normal;
+  }
+
+  // If light intensity is negative(surface isn't facing light), the intensity should be 0
+  float lightIntensity = AMBIENT + max(dot(normal, fragDirectionToLight), 0);
+  outColor = vec4(lightIntensity * fragColor, 1.0);
+}
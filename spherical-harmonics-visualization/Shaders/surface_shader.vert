@@ -0,0 +1,61 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : require
+
+// Sample points of a spherical function read per vertex, the triangles come from the index buffer of a SphereMesh
+layout(location = 4) in vec3 samplePosition;
+layout(location = 5) in float sampleValue;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragWorldPosition;
+layout(location = 2) out vec3 fragOutward;
+layout(location = 3) flat out vec3 fragDirectionToLight;
+
+// Specialization constants, see SimpleRenderSystem::PointStyle. SH_ORDER and COLOR_MODE are declared in sh_common.glsl
+#include "sh_common.glsl"
+layout(constant_id = 3) const bool DISPLACE = true;	// Radius |f(dir)| (SH glyph) instead of a sphere
+
+layout (set=0, binding = 0) uniform UBO 
+{
+  mat4 projectionMatrix;
+  vec3 directionToLight;
+  mat4 view;
+} ubo;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+  float colorScale;
+  float pointScale;
+} push;
+
+// Compiled with RECONSTRUCTION for the reconstruction, which evaluates the value from the coefficients instead
+#ifdef RECONSTRUCTION
+// SH coefficients up to order 3, indexed by l(l+1)+m
+layout (set=1, binding = 0) uniform SHCoefficients
+{
+  vec4 coeffs[4];
+} sh;
+
+float sampleFunction() {
+  return evalSHSum(normalize(samplePosition), sh.coeffs);
+}
+#else
+float sampleFunction() {
+  return sampleValue;
+}
+#endif
+
+void main() {
+  float value = sampleFunction();
+
+  // Sample positions lie on the sphere of the function, the glyph scales them by the magnitude of the value
+  vec3 position = DISPLACE ? abs(value) * samplePosition : samplePosition;
+  vec4 worldPosition = push.modelMatrix * vec4(position, 1.0);
+  gl_Position = ubo.projectionMatrix * ubo.view * worldPosition;
+
+  fragColor = valueColor(value, push.colorScale);
+  fragWorldPosition = worldPosition.xyz;
+  fragOutward = mat3(push.modelMatrix) * samplePosition;
+  fragDirectionToLight = ubo.directionToLight;
+}
@@ -1,3 +1,11 @@
 C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\simple_shader.vert -o Shaders\simple_shader.vert.spv
 C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\simple_shader.frag -o Shaders\simple_shader.frag.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\point_shader.vert -o Shaders\point_shader.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe -DCOMPACT_VERTEX Shaders\point_shader.vert -o Shaders\point_shader_compact.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\point_shader.frag -o Shaders\point_shader.frag.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\sh_reconstruction_shader.vert -o Shaders\sh_reconstruction_shader.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe -DCOMPACT_VERTEX Shaders\sh_reconstruction_shader.vert -o Shaders\sh_reconstruction_shader_compact.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\surface_shader.vert -o Shaders\surface_shader.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe -DRECONSTRUCTION Shaders\surface_shader.vert -o Shaders\surface_reconstruction_shader.vert.spv
+C:\VulkanSDK\1.3.216.0\Bin\glslc.exe Shaders\surface_shader.frag -o Shaders\surface_shader.frag.spv
 pause
\ No newline at end of file
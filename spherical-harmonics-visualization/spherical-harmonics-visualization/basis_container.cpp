@@ -1,71 +1,41 @@
 #include "basis_container.hpp"
 #include "simple_render_system.hpp"
 
+#include <cassert>
+#include <glm/gtc/matrix_transform.hpp>
+
 namespace vvt {
-	BasisContainer::BasisContainer(double coeff, int order, int degree, float radius, glm::vec3 pos, glm::vec3 rot): order{order}, degree{degree}, radius{radius}, coefficient{coeff}
+	BasisContainer::BasisContainer(std::shared_ptr<ShBasisTable> table, std::shared_ptr<SphereMesh> surfaceMesh, double coeff, int order, int degree, float radius, glm::vec3 pos): table{table}, surfaceMesh{surfaceMesh}, column{sh::GetIndex(order, degree)}, coefficient{coeff}, order{order}, degree{degree}, radius{radius}, center{pos}
 	{
-		transform.translation = pos;
-		transform.rotation = rot;
-		transform.scale = { 1.0f, 1.0f, 1.0f };
-		generatePoints(order, degree);
+		assert(order <= this->table->getOrder() && "The basis table doesn't contain this basis function!");
 	}
 
 	void BasisContainer::render(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, std::shared_ptr<VvtModel> pointModel, double maxCoeff)
 	{
-		for (auto& p : points)
-		{
-			TransformComponent pointTransform;
-			pointTransform.translation = p.first;
-			pointTransform.scale = { 0.03f, 0.03f, 0.03f };
-
-			TestPushConstant push{};
-			push.modelMatrix = pointTransform.mat4();
-			push.normalMatrix = pointTransform.normalMatrix();
-			if (p.second < 0.0f)
-			{
-				push.color =  {0.0f, 0.0f, (abs(coefficient)/maxCoeff) * abs(p.second) };
-			}
-			else {
-				push.color = { (abs(coefficient)/maxCoeff) * abs(p.second), 0.0f, 0.0f };
-			}
+		// The table holds unit directions, the model matrix places them on this basis function's sphere
+		PointPushConstant push{};
+		push.modelMatrix = glm::scale(glm::translate(glm::mat4{ 1.0f }, center), glm::vec3{ radius });
 
-			vkCmdPushConstants(
-				commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(TestPushConstant),
-				&push);
+		// Basis functions are colored by the relative magnitude of their coefficient
+		push.colorScale = static_cast<float>(abs(coefficient) / maxCoeff);
 
-			pointModel->bind(commandBuffer);
-			pointModel->draw(commandBuffer);
-		}
-	}
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			sizeof(PointPushConstant),
+			&push);
 
+		PointInstance::bind(commandBuffer, table->getDirectionBuffer(), 0, table->getValueBuffer(), table->getColumnOffset(column));
 
-	void BasisContainer::generatePoints(int order, int degree)
-	{
-		for (int i = 0; i < resolution; i++)
+		if (surfaceMesh)
 		{
-			for (int j = 0; j < resolution; j++)
-			{
-				float phi = (static_cast<float>(i) / static_cast<float>(resolution)) * 2 * glm::pi<float>();
-				float theta = (static_cast<float>(j) / static_cast<float>(resolution)) * glm::pi<float>();
-				addSphere3DPoint(phi, theta);
-			}
+			surfaceMesh->draw(commandBuffer);
+			return;
 		}
-	}
-
-	void BasisContainer::addSphere3DPoint(double phi, double theta)
-	{
-		Eigen::Vector3d dirVectorFromSphericalCoords = sh::ToVector(phi, theta);
-		glm::vec3 glmDirVector = { dirVectorFromSphericalCoords.x(), dirVectorFromSphericalCoords.y(), dirVectorFromSphericalCoords.z() };
 
-		glm::vec3 pointPos = transform.translation + glm::normalize(glmDirVector) * radius;
-		double pointValue = sh::EvalSH(order, degree, phi, theta);
-
-		points.push_back(std::make_pair(pointPos, pointValue));
+		// The point model is already bound by the owning SphereContainer
+		pointModel->draw(commandBuffer, table->getDirectionCount());
 	}
-
-
-}
\ No newline at end of file
+}
@@ -1,32 +1,39 @@
 #pragma once
 #include "vvt_model.hpp"
 #include "spherical_harmonics.h"
-#include "vvt_game_object.hpp"
+#include "point_instance.hpp"
+#include "sh_basis_table.hpp"
+#include "sphere_mesh.hpp"
 
-#include <vector>
+#include <memory>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
 namespace vvt {
+	/*
+	* A single basis function Y_lm drawn as a point cloud, or as a surface if it has a mesh. The container only stores
+	* where to draw it, the directions and values are a column of the shared ShBasisTable.
+	*/
 	class BasisContainer
 	{
 	public:
-		BasisContainer(double coeff, int order, int degree, float radius, glm::vec3 pos, glm::vec3 rot);
+		// The mesh has to be built on the directions of the table, see SphereMesh
+		BasisContainer(std::shared_ptr<ShBasisTable> table, std::shared_ptr<SphereMesh> surfaceMesh, double coeff, int order, int degree, float radius, glm::vec3 pos);
 
 		void render(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, std::shared_ptr<VvtModel> pointModel, double maxCoeff);
 
-	private:
-		void generatePoints(int order, int degree);
-		void addSphere3DPoint(double phi, double theta);
+		int getOrder() const { return order; }
+		int getDegree() const { return degree; }
+		void setCoefficient(double coeff) { coefficient = coeff; }
 
+	private:
+		std::shared_ptr<ShBasisTable> table;
+		std::shared_ptr<SphereMesh> surfaceMesh;
+		int column;
 		double coefficient;
 		int order;
-		int degree;		
+		int degree;
 		float radius;
-		TransformComponent transform;
-
-		std::vector<std::pair<glm::vec3, double>> points;
-
-		int resolution = 80;
+		glm::vec3 center;
 	};
 }
@@ -1,4 +1,8 @@
 #pragma once
 namespace vvt{
 	enum MoveDirection { POSX, NEGX, POSY, NEGY, POSZ, NEGZ };
+	enum ProjectionMethod { MONTE_CARLO, GAUSS_LEGENDRE, LEBEDEV };
+	enum ColorMode { SIGNED_RED_BLUE, COLOR_MAP };
+	enum SamplingScheme { SPHERICAL_GRID, FIBONACCI_LATTICE, HEALPIX, ICOSPHERE };
+	enum VisualizationMode { POINT_CLOUD, DISPLACED_SURFACE, COLORED_SURFACE };
 }
\ No newline at end of file
@@ -1,15 +1,20 @@
 #include "vvt_app.hpp"
+#include "vvt_profiler.hpp"
 // std
 #include <stdlib.h>
 #include <iostream>
 #include <stdexcept>
 
-int main()
+int main(int argc, char* argv[])
 {
-	vvt::VvtApp app{};
+	VVT_PROFILE_THREAD_NAME("Main");
 	try 
 	{
+		vvt::VvtApp app{ vvt::VvtAppSettings::fromCommandLine(argc, argv) };
 		app.run();
+
+		// Only does something in builds with VVT_ENABLE_PROFILING
+		VVT_PROFILE_WRITE_TRACE("vvt_trace.json");
 	}
 	catch (const std::exception& e)
 	{
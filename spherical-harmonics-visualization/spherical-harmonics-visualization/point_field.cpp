@@ -0,0 +1,35 @@
+#include "point_field.hpp"
+#include "point_instance.hpp"
+
+namespace vvt {
+
+	void PointField::reserve(size_t count)
+	{
+		positions.reserve(3 * count);
+		values.reserve(count);
+	}
+
+	void PointField::clear()
+	{
+		positions.clear();
+		values.clear();
+	}
+
+	void PointField::push_back(const glm::vec3& position, float value)
+	{
+		positions.push_back(position.x);
+		positions.push_back(position.y);
+		positions.push_back(position.z);
+		values.push_back(value);
+	}
+
+	void PointField::updatePositionBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& buffer) const
+	{
+		PointInstance::updateInstanceBuffer(device, buffer, positions.data(), 3 * sizeof(float), static_cast<uint32_t>(size()));
+	}
+
+	void PointField::updateValueBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& buffer) const
+	{
+		PointInstance::updateInstanceBuffer(device, buffer, values.data(), sizeof(float), static_cast<uint32_t>(size()));
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "vvt_buffer.hpp"
+#include "vvt_device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Sample points of a spherical function as a structure of arrays: tightly packed xyz float positions and
+	* float values. Both arrays have exactly the layout of the PointInstance streams, so they are uploaded as
+	* they are, and loops touching only positions or only values stream through contiguous floats.
+	*
+	* Fill either by constructing with the final size and writing setPoint, or by reserve and push_back.
+	*/
+	class PointField
+	{
+	public:
+		PointField() = default;
+		explicit PointField(size_t count) : positions(3 * count), values(count) {}
+
+		size_t size() const { return values.size(); }
+		bool empty() const { return values.empty(); }
+
+		void reserve(size_t count);
+		void clear();
+		void push_back(const glm::vec3& position, float value);
+
+		void setPoint(size_t index, const glm::vec3& position, float value)
+		{
+			assert(index < size() && "Point index out of range!");
+			positions[3 * index] = position.x;
+			positions[3 * index + 1] = position.y;
+			positions[3 * index + 2] = position.z;
+			values[index] = value;
+		}
+
+		glm::vec3 getPosition(size_t index) const { return { positions[3 * index], positions[3 * index + 1], positions[3 * index + 2] }; }
+		float getValue(size_t index) const { return values[index]; }
+
+		// xyz of point i at [3i, 3i + 2]
+		float* positionData() { return positions.data(); }
+		const float* positionData() const { return positions.data(); }
+		float* valueData() { return values.data(); }
+		const float* valueData() const { return values.data(); }
+
+		// Uploads the position and value streams of PointInstance, reusing the buffers when they are large enough
+		void updatePositionBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& buffer) const;
+		void updateValueBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& buffer) const;
+
+	private:
+		std::vector<float> positions;
+		std::vector<float> values;
+	};
+}
@@ -0,0 +1,73 @@
+#include "point_instance.hpp"
+
+// std
+#include <cassert>
+
+namespace vvt {
+
+	// Instance data is bound right after the per-vertex data of the point model (binding 0)
+	std::vector<VkVertexInputBindingDescription> PointInstance::getBindingDescriptions(VkVertexInputRate inputRate)
+	{
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
+		bindingDescriptions[0].binding = POSITION_BINDING;
+		bindingDescriptions[0].stride = sizeof(glm::vec3);
+		bindingDescriptions[0].inputRate = inputRate;
+
+		bindingDescriptions[1].binding = VALUE_BINDING;
+		bindingDescriptions[1].stride = sizeof(float);
+		bindingDescriptions[1].inputRate = inputRate;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> PointInstance::getAttributeDescriptions()
+	{
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+
+		// instance position
+		attributeDescriptions[0].binding = POSITION_BINDING;
+		attributeDescriptions[0].location = 4;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+		attributeDescriptions[0].offset = 0;
+
+		// instance value (sign and magnitude determine the color)
+		attributeDescriptions[1].binding = VALUE_BINDING;
+		attributeDescriptions[1].location = 5;
+		attributeDescriptions[1].format = VK_FORMAT_R32_SFLOAT;
+		attributeDescriptions[1].offset = 0;
+		return attributeDescriptions;
+	}
+
+	std::unique_ptr<VvtBuffer> PointInstance::createInstanceBuffer(VvtDevice& device, const void* data, VkDeviceSize elementSize, uint32_t elementCount)
+	{
+		std::unique_ptr<VvtBuffer> instanceBuffer;
+		updateInstanceBuffer(device, instanceBuffer, data, elementSize, elementCount);
+		return instanceBuffer;
+	}
+
+	void PointInstance::updateInstanceBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& instanceBuffer, const void* data, VkDeviceSize elementSize, uint32_t elementCount)
+	{
+		assert(elementCount > 0 && "Cannot create an instance buffer without instances!");
+
+		// Draws take their instance count from the point field, so a larger buffer is simply not read to the end
+		VkDeviceSize size = elementSize * elementCount;
+		if (!instanceBuffer || instanceBuffer->getBufferSize() < size)
+		{
+			instanceBuffer = std::make_unique<VvtBuffer>(
+				device,
+				elementSize,
+				elementCount,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		device.getUploadManager().uploadBuffer(
+			instanceBuffer->getBuffer(), data, size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	}
+
+	void PointInstance::bind(VkCommandBuffer commandBuffer, VkBuffer positionBuffer, VkDeviceSize positionOffset, VkBuffer valueBuffer, VkDeviceSize valueOffset)
+	{
+		VkBuffer buffers[] = { positionBuffer, valueBuffer };
+		VkDeviceSize offsets[] = { positionOffset, valueOffset };
+		vkCmdBindVertexBuffers(commandBuffer, POSITION_BINDING, 2, buffers, offsets);
+	}
+}
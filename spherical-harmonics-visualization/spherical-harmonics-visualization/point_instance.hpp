@@ -0,0 +1,37 @@
+#pragma once
+#include "vvt_buffer.hpp"
+#include "vvt_device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vvt {
+	/*
+	* Per-instance vertex input of the point clouds of spherical functions. A container draws the point model
+	* once with one instance per sample point, instead of issuing a draw call for every point.
+	*
+	* Positions (binding 1) and values (binding 2) are separate streams, so point clouds can share a position
+	* buffer and bind their values as a column of a larger table.
+	*/
+	struct PointInstance {
+		static constexpr uint32_t POSITION_BINDING = 1;
+		static constexpr uint32_t VALUE_BINDING = 2;
+
+		// Surfaces read the same streams per vertex, see SphereMesh
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_INSTANCE);
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+		// Device local instance buffer, the copy is part of the next upload batch
+		static std::unique_ptr<VvtBuffer> createInstanceBuffer(VvtDevice& device, const void* data, VkDeviceSize elementSize, uint32_t elementCount);
+		// Uploads into instanceBuffer if it is large enough and only creates a new one otherwise. The GPU must be done with the old contents
+		static void updateInstanceBuffer(VvtDevice& device, std::unique_ptr<VvtBuffer>& instanceBuffer, const void* data, VkDeviceSize elementSize, uint32_t elementCount);
+
+		static void bind(VkCommandBuffer commandBuffer, VkBuffer positionBuffer, VkDeviceSize positionOffset, VkBuffer valueBuffer, VkDeviceSize valueOffset);
+	};
+}
@@ -0,0 +1,46 @@
+#include "sh_basis_table.hpp"
+#include "point_instance.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+
+namespace vvt {
+
+	std::mutex ShBasisTable::cacheMutex;
+	std::map<std::tuple<SamplingScheme, uint32_t, int>, std::weak_ptr<ShBasisTable>> ShBasisTable::cache;
+
+	std::shared_ptr<ShBasisTable> ShBasisTable::get(VvtDevice& device, SamplingScheme scheme, uint32_t targetCount, int order)
+	{
+		std::lock_guard<std::mutex> lock{ cacheMutex };
+
+		auto key = std::make_tuple(scheme, targetCount, order);
+		if (auto table = cache[key].lock())
+		{
+			assert(&table->vvtDevice == &device && "Basis tables are shared process-wide and have to be used with a single device!");
+			return table;
+		}
+
+		auto table = std::make_shared<ShBasisTable>(device, scheme, targetCount, order);
+		cache[key] = table;
+		return table;
+	}
+
+	ShBasisTable::ShBasisTable(VvtDevice& device, SamplingScheme scheme, uint32_t targetCount, int order) : vvtDevice{ device }, scheme{ scheme }, order{ order }
+	{
+		directions = ShDirections::sample(scheme, targetCount);
+		values = ShEvaluator(order).evaluate(directions);
+
+		// Instance positions are interleaved xyz
+		std::vector<glm::vec3> directionData(directions.size());
+		for (size_t i = 0; i < directions.size(); i++)
+		{
+			directionData[i] = { directions.x[i], directions.y[i], directions.z[i] };
+		}
+
+		directionBuffer = PointInstance::createInstanceBuffer(vvtDevice, directionData.data(), sizeof(glm::vec3), getDirectionCount());
+		valueBuffer = PointInstance::createInstanceBuffer(vvtDevice, values.data(), sizeof(float), static_cast<uint32_t>(values.size()));
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "vvt_device.hpp"
+#include "vvt_buffer.hpp"
+#include "sh_evaluator.hpp"
+
+// std
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Unit directions of a sampling scheme together with all Y_lm up to an order evaluated at these directions,
+	* both on the CPU and as GPU instance buffers. Tables are shared process-wide per (scheme, point count, order):
+	* every BasisContainer of the same sampling only references a column of the same table.
+	*
+	* Values are stored column by column: getValues()[k * getDirectionCount() + i] is Y_k of direction i, with
+	* k = l(l+1)+m, so a column can be bound directly as the value stream of a point cloud.
+	*/
+	class ShBasisTable
+	{
+	public:
+		// Returns the cached table or creates it, the table lives as long as someone holds a reference to it
+		// The table holds ShDirections::sampleCount(scheme, targetCount) directions
+		static std::shared_ptr<ShBasisTable> get(VvtDevice& device, SamplingScheme scheme, uint32_t targetCount, int order);
+
+		ShBasisTable(VvtDevice& device, SamplingScheme scheme, uint32_t targetCount, int order);
+
+		ShBasisTable(const ShBasisTable&) = delete;
+		ShBasisTable& operator=(const ShBasisTable&) = delete;
+
+		SamplingScheme getSamplingScheme() const { return scheme; }
+		int getOrder() const { return order; }
+		uint32_t getDirectionCount() const { return static_cast<uint32_t>(directions.size()); }
+		const ShDirections& getDirections() const { return directions; }
+		const std::vector<float>& getValues() const { return values; }
+		const float* getColumn(int index) const { return &values[static_cast<size_t>(index) * directions.size()]; }
+
+		VkBuffer getDirectionBuffer() const { return directionBuffer->getBuffer(); }
+		VkBuffer getValueBuffer() const { return valueBuffer->getBuffer(); }
+		VkDeviceSize getColumnOffset(int index) const { return static_cast<VkDeviceSize>(index) * directions.size() * sizeof(float); }
+
+	private:
+		VvtDevice& vvtDevice;
+		SamplingScheme scheme;
+		int order;
+
+		ShDirections directions;
+		std::vector<float> values;
+
+		std::unique_ptr<VvtBuffer> directionBuffer;
+		std::unique_ptr<VvtBuffer> valueBuffer;
+
+		static std::mutex cacheMutex;
+		static std::map<std::tuple<SamplingScheme, uint32_t, int>, std::weak_ptr<ShBasisTable>> cache;
+	};
+}
@@ -0,0 +1,178 @@
+#include "sh_coefficient_cache.hpp"
+#include "vvt_mapped_file.hpp"
+#include "vvt_utils.hpp"
+
+// std
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace vvt {
+
+	namespace {
+
+		constexpr char FILE_MAGIC[4] = { 'V', 'V', 'S', 'H' };
+
+		/*
+		* File layout: header, coefficients (doubles), function id (chars), description (chars).
+		* The checksum covers the header with the checksum field set to zero, followed by the payload.
+		*/
+		struct CacheFileHeader {
+			char magic[4];
+			uint32_t version;
+			uint64_t keyHash;
+			int32_t order;
+			int32_t method;
+			uint64_t sampleCount;
+			uint64_t seed;
+			uint32_t coefficientCount;
+			uint32_t functionIdLength;
+			uint32_t descriptionLength;
+			uint32_t reserved;
+			double errorEstimate;
+			uint64_t functionEvaluations;
+			uint64_t checksum;
+		};
+
+		static_assert(sizeof(CacheFileHeader) == 80, "The cache file header must not contain padding!");
+
+		uint64_t checksum(CacheFileHeader header, const unsigned char* payload, size_t payloadSize)
+		{
+			header.checksum = 0;
+			uint64_t hash = hashBytes(&header, sizeof(header));
+			return hashBytes(payload, payloadSize, hash);
+		}
+	}
+
+	uint64_t ShCoefficientCacheKey::hash() const
+	{
+		int32_t fields[2] = { order, static_cast<int32_t>(method) };
+		uint64_t counts[2] = { sampleCount, seed };
+
+		uint64_t hash = hashBytes(functionId.data(), functionId.size());
+		hash = hashBytes(fields, sizeof(fields), hash);
+		return hashBytes(counts, sizeof(counts), hash);
+	}
+
+	ShCoefficientCache::ShCoefficientCache(const std::string& directory) : directory{ directory } {}
+
+	std::string ShCoefficientCache::getFilepath(const ShCoefficientCacheKey& key) const
+	{
+		char filename[32];
+		std::snprintf(filename, sizeof(filename), "%016llx.shc", static_cast<unsigned long long>(key.hash()));
+		return (std::filesystem::path{ directory } / filename).string();
+	}
+
+	bool ShCoefficientCache::load(const ShCoefficientCacheKey& key, ShProjection& projection) const
+	{
+		VvtMappedFile file{ getFilepath(key) };
+		if (!file.isOpen() || file.size() < sizeof(CacheFileHeader))
+		{
+			return false;
+		}
+
+		CacheFileHeader header;
+		std::memcpy(&header, file.data(), sizeof(header));
+
+		// Reject files of other versions and hash collisions before touching the payload
+		if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+			header.version != FILE_VERSION ||
+			header.keyHash != key.hash() ||
+			header.order != key.order ||
+			header.method != static_cast<int32_t>(key.method) ||
+			header.sampleCount != key.sampleCount ||
+			header.seed != key.seed ||
+			header.coefficientCount != static_cast<uint32_t>((key.order + 1) * (key.order + 1)) ||
+			header.functionIdLength != key.functionId.size())
+		{
+			return false;
+		}
+
+		size_t coefficientBytes = header.coefficientCount * sizeof(double);
+		size_t payloadSize = coefficientBytes + header.functionIdLength + header.descriptionLength;
+		if (file.size() != sizeof(CacheFileHeader) + payloadSize)
+		{
+			return false;
+		}
+
+		const unsigned char* payload = file.data() + sizeof(CacheFileHeader);
+		if (checksum(header, payload, payloadSize) != header.checksum)
+		{
+			return false;
+		}
+
+		if (std::memcmp(payload + coefficientBytes, key.functionId.data(), header.functionIdLength) != 0)
+		{
+			return false;
+		}
+
+		projection.coeffs.resize(header.coefficientCount);
+		std::memcpy(projection.coeffs.data(), payload, coefficientBytes);
+		projection.errorEstimate = header.errorEstimate;
+		projection.functionEvaluations = static_cast<size_t>(header.functionEvaluations);
+		projection.description.assign(reinterpret_cast<const char*>(payload + coefficientBytes + header.functionIdLength), header.descriptionLength);
+		return true;
+	}
+
+	bool ShCoefficientCache::store(const ShCoefficientCacheKey& key, const ShProjection& projection) const
+	{
+		CacheFileHeader header{};
+		std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+		header.version = FILE_VERSION;
+		header.keyHash = key.hash();
+		header.order = key.order;
+		header.method = static_cast<int32_t>(key.method);
+		header.sampleCount = key.sampleCount;
+		header.seed = key.seed;
+		header.coefficientCount = static_cast<uint32_t>(projection.coeffs.size());
+		header.functionIdLength = static_cast<uint32_t>(key.functionId.size());
+		header.descriptionLength = static_cast<uint32_t>(projection.description.size());
+		header.errorEstimate = projection.errorEstimate;
+		header.functionEvaluations = projection.functionEvaluations;
+
+		std::vector<unsigned char> payload(projection.coeffs.size() * sizeof(double) + key.functionId.size() + projection.description.size());
+		unsigned char* writePtr = payload.data();
+		std::memcpy(writePtr, projection.coeffs.data(), projection.coeffs.size() * sizeof(double));
+		writePtr += projection.coeffs.size() * sizeof(double);
+		std::memcpy(writePtr, key.functionId.data(), key.functionId.size());
+		writePtr += key.functionId.size();
+		std::memcpy(writePtr, projection.description.data(), projection.description.size());
+
+		header.checksum = checksum(header, payload.data(), payload.size());
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		if (error)
+		{
+			return false;
+		}
+
+		// Write to a temporary file first, so a crash never leaves a truncated entry behind
+		std::string filepath = getFilepath(key);
+		std::string tempFilepath = filepath + ".tmp";
+		{
+			std::ofstream file{ tempFilepath, std::ios::binary | std::ios::trunc };
+			if (!file.is_open())
+			{
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+			if (!file)
+			{
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempFilepath, filepath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempFilepath, error);
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "sh_projection.hpp"
+#include "enums.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vvt {
+
+	// Everything the coefficients of a projection depend on
+	struct ShCoefficientCacheKey {
+		std::string functionId;		// User supplied, e.g. the expression of the function
+		int order = 0;
+		ProjectionMethod method = MONTE_CARLO;
+		uint64_t sampleCount = 0;
+		uint64_t seed = 0;
+
+		uint64_t hash() const;
+	};
+
+	/*
+	* Persistent cache of projected SH coefficients, one small binary file per key in a cache directory.
+	* Files are memory-mapped on load and only accepted if their header matches the key and the checksum
+	* over header and payload is valid, anything else is treated as a miss and overwritten on the next store.
+	*/
+	class ShCoefficientCache
+	{
+	public:
+		static constexpr uint32_t FILE_VERSION = 1;
+
+		explicit ShCoefficientCache(const std::string& directory);
+
+		// Returns false if there is no valid entry for the key
+		bool load(const ShCoefficientCacheKey& key, ShProjection& projection) const;
+
+		// Failing to write is not an error, the projection will just be recomputed next time
+		bool store(const ShCoefficientCacheKey& key, const ShProjection& projection) const;
+
+		std::string getFilepath(const ShCoefficientCacheKey& key) const;
+
+	private:
+		std::string directory;
+	};
+}
@@ -0,0 +1,488 @@
+#include "sh_evaluator.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VVT_SH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VVT_SH_SSE2
+#endif
+
+namespace vvt {
+
+	namespace {
+
+		const double PI = 3.14159265358979323846;
+		// 655362 vertices
+		const int MAX_ICOSPHERE_SUBDIVISIONS = 8;
+
+		/*
+		* Minimal SIMD wrappers, so the recurrence is written once and instantiated per instruction set.
+		* Every wrapper offers set/load/store plus addition and multiplication.
+		*/
+		template <typename T>
+		struct ScalarVec {
+			static constexpr size_t width = 1;
+			T v;
+
+			static ScalarVec set(T s) { return { s }; }
+			static ScalarVec load(const T* p) { return { *p }; }
+			void store(T* p) const { *p = v; }
+			ScalarVec operator+(ScalarVec o) const { return { v + o.v }; }
+			ScalarVec operator-(ScalarVec o) const { return { v - o.v }; }
+			ScalarVec operator*(ScalarVec o) const { return { v * o.v }; }
+		};
+
+#if defined(VVT_SH_AVX2)
+		struct FloatVec {
+			static constexpr size_t width = 8;
+			__m256 v;
+
+			static FloatVec set(float s) { return { _mm256_set1_ps(s) }; }
+			static FloatVec load(const float* p) { return { _mm256_loadu_ps(p) }; }
+			void store(float* p) const { _mm256_storeu_ps(p, v); }
+			FloatVec operator+(FloatVec o) const { return { _mm256_add_ps(v, o.v) }; }
+			FloatVec operator-(FloatVec o) const { return { _mm256_sub_ps(v, o.v) }; }
+			FloatVec operator*(FloatVec o) const { return { _mm256_mul_ps(v, o.v) }; }
+		};
+
+		struct DoubleVec {
+			static constexpr size_t width = 4;
+			__m256d v;
+
+			static DoubleVec set(double s) { return { _mm256_set1_pd(s) }; }
+			static DoubleVec load(const double* p) { return { _mm256_loadu_pd(p) }; }
+			void store(double* p) const { _mm256_storeu_pd(p, v); }
+			DoubleVec operator+(DoubleVec o) const { return { _mm256_add_pd(v, o.v) }; }
+			DoubleVec operator-(DoubleVec o) const { return { _mm256_sub_pd(v, o.v) }; }
+			DoubleVec operator*(DoubleVec o) const { return { _mm256_mul_pd(v, o.v) }; }
+		};
+#elif defined(VVT_SH_SSE2)
+		struct FloatVec {
+			static constexpr size_t width = 4;
+			__m128 v;
+
+			static FloatVec set(float s) { return { _mm_set1_ps(s) }; }
+			static FloatVec load(const float* p) { return { _mm_loadu_ps(p) }; }
+			void store(float* p) const { _mm_storeu_ps(p, v); }
+			FloatVec operator+(FloatVec o) const { return { _mm_add_ps(v, o.v) }; }
+			FloatVec operator-(FloatVec o) const { return { _mm_sub_ps(v, o.v) }; }
+			FloatVec operator*(FloatVec o) const { return { _mm_mul_ps(v, o.v) }; }
+		};
+
+		struct DoubleVec {
+			static constexpr size_t width = 2;
+			__m128d v;
+
+			static DoubleVec set(double s) { return { _mm_set1_pd(s) }; }
+			static DoubleVec load(const double* p) { return { _mm_loadu_pd(p) }; }
+			void store(double* p) const { _mm_storeu_pd(p, v); }
+			DoubleVec operator+(DoubleVec o) const { return { _mm_add_pd(v, o.v) }; }
+			DoubleVec operator-(DoubleVec o) const { return { _mm_sub_pd(v, o.v) }; }
+			DoubleVec operator*(DoubleVec o) const { return { _mm_mul_pd(v, o.v) }; }
+		};
+#else
+		using FloatVec = ScalarVec<float>;
+		using DoubleVec = ScalarVec<double>;
+#endif
+
+		template <typename T> struct NativeVec;
+		template <> struct NativeVec<float> { using type = FloatVec; };
+		template <> struct NativeVec<double> { using type = DoubleVec; };
+
+		double factorial(int n)
+		{
+			double result = 1.0;
+			for (int i = 2; i <= n; i++)
+			{
+				result *= i;
+			}
+			return result;
+		}
+
+		int getIndex(int l, int m)
+		{
+			return l * (l + 1) + m;
+		}
+
+		void pushSpherical(ShDirections& directions, double z, double phi)
+		{
+			double sinTheta = std::sqrt(std::max(0.0, 1.0 - z * z));
+			directions.push_back(
+				static_cast<float>(std::cos(phi) * sinTheta),
+				static_cast<float>(std::sin(phi) * sinTheta),
+				static_cast<float>(z));
+		}
+
+		int getGridResolution(uint32_t targetCount)
+		{
+			return std::max(1, static_cast<int>(std::lround(std::sqrt(static_cast<double>(targetCount)))));
+		}
+
+		using Vector3 = std::array<double, 3>;
+
+		Vector3 normalize(const Vector3& v)
+		{
+			double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			return { v[0] / length, v[1] / length, v[2] / length };
+		}
+
+		uint32_t getIcosphereVertexCount(int subdivisions)
+		{
+			return 10 * (1u << (2 * subdivisions)) + 2;
+		}
+
+		int getHealpixNside(uint32_t targetCount)
+		{
+			return std::max(1, static_cast<int>(std::lround(std::sqrt(static_cast<double>(targetCount) / 12.0))));
+		}
+	}
+
+	void ShDirections::reserve(size_t count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+	}
+
+	void ShDirections::push_back(float dirX, float dirY, float dirZ)
+	{
+		x.push_back(dirX);
+		y.push_back(dirY);
+		z.push_back(dirZ);
+	}
+
+	ShDirections ShDirections::sphericalGrid(int resolution)
+	{
+		ShDirections directions;
+		directions.reserve(static_cast<size_t>(resolution) * resolution);
+
+		for (int i = 0; i < resolution; i++)
+		{
+			for (int j = 0; j < resolution; j++)
+			{
+				float phi = (static_cast<float>(i) / static_cast<float>(resolution)) * 2 * static_cast<float>(PI);
+				float theta = (static_cast<float>(j) / static_cast<float>(resolution)) * static_cast<float>(PI);
+
+				double sinTheta = std::sin(static_cast<double>(theta));
+				directions.push_back(
+					static_cast<float>(std::cos(static_cast<double>(phi)) * sinTheta),
+					static_cast<float>(std::sin(static_cast<double>(phi)) * sinTheta),
+					static_cast<float>(std::cos(static_cast<double>(theta))));
+			}
+		}
+		return directions;
+	}
+
+	ShDirections ShDirections::fibonacciLattice(uint32_t count)
+	{
+		ShDirections directions;
+		directions.reserve(count);
+
+		// z is stratified into count bands of equal area, phi advances by the golden angle so no two points line up
+		const double goldenAngle = PI * (3.0 - std::sqrt(5.0));
+		for (uint32_t i = 0; i < count; i++)
+		{
+			double z = 1.0 - (2.0 * i + 1.0) / count;
+			pushSpherical(directions, z, goldenAngle * i);
+		}
+		return directions;
+	}
+
+	ShDirections ShDirections::healpix(int nside)
+	{
+		assert(nside > 0 && "HEALPix needs at least one pixel per base pixel side!");
+		ShDirections directions;
+		directions.reserve(12 * static_cast<size_t>(nside) * nside);
+
+		// Rings 1 to 4 nside - 1, polar rings hold 4i pixels, the 2 nside + 1 equatorial rings 4 nside each
+		const double n = static_cast<double>(nside);
+		for (int ring = 1; ring < 4 * nside; ring++)
+		{
+			int polarRing = std::min(ring, 4 * nside - ring);
+			double z;
+			int pixels;
+			double phiOffset;
+			if (polarRing < nside)
+			{
+				z = 1.0 - static_cast<double>(polarRing) * polarRing / (3.0 * n * n);
+				pixels = 4 * polarRing;
+				phiOffset = 0.5;
+			}
+			else
+			{
+				z = 4.0 / 3.0 - 2.0 * polarRing / (3.0 * n);
+				pixels = 4 * nside;
+				phiOffset = ((ring - nside + 1) % 2) * 0.5;
+			}
+			if (ring > 2 * nside)
+			{
+				z = -z;
+			}
+
+			for (int j = 1; j <= pixels; j++)
+			{
+				pushSpherical(directions, z, 2.0 * PI / pixels * (j - phiOffset));
+			}
+		}
+		return directions;
+	}
+
+	ShDirections ShDirections::icosphere(int subdivisions, std::vector<uint32_t>* triangles)
+	{
+		assert(subdivisions >= 0 && "The icosphere cannot have a negative amount of subdivisions!");
+
+		// The icosahedron's vertices are the cyclic permutations of (0, +-1, +-golden ratio)
+		const double t = (1.0 + std::sqrt(5.0)) / 2.0;
+		std::vector<Vector3> vertices = {
+			{ -1.0, t, 0.0 }, { 1.0, t, 0.0 }, { -1.0, -t, 0.0 }, { 1.0, -t, 0.0 },
+			{ 0.0, -1.0, t }, { 0.0, 1.0, t }, { 0.0, -1.0, -t }, { 0.0, 1.0, -t },
+			{ t, 0.0, -1.0 }, { t, 0.0, 1.0 }, { -t, 0.0, -1.0 }, { -t, 0.0, 1.0 } };
+		for (auto& vertex : vertices)
+		{
+			vertex = normalize(vertex);
+		}
+		std::vector<uint32_t> indices = {
+			0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+			1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+			4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+
+		// Every triangle is split into four, edges shared by two triangles get a single midpoint
+		vertices.reserve(getIcosphereVertexCount(subdivisions));
+		for (int level = 0; level < subdivisions; level++)
+		{
+			std::unordered_map<uint64_t, uint32_t> midpoints;
+			auto getMidpoint = [&](uint32_t a, uint32_t b)
+			{
+				uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+				auto [it, inserted] = midpoints.emplace(key, static_cast<uint32_t>(vertices.size()));
+				if (inserted)
+				{
+					const Vector3& va = vertices[a];
+					const Vector3& vb = vertices[b];
+					vertices.push_back(normalize({ va[0] + vb[0], va[1] + vb[1], va[2] + vb[2] }));
+				}
+				return it->second;
+			};
+
+			std::vector<uint32_t> subdivided;
+			subdivided.reserve(4 * indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+				uint32_t ab = getMidpoint(a, b), bc = getMidpoint(b, c), ca = getMidpoint(c, a);
+				subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+			}
+			indices = std::move(subdivided);
+		}
+
+		ShDirections directions;
+		directions.reserve(vertices.size());
+		for (const auto& vertex : vertices)
+		{
+			directions.push_back(static_cast<float>(vertex[0]), static_cast<float>(vertex[1]), static_cast<float>(vertex[2]));
+		}
+		if (triangles)
+		{
+			*triangles = std::move(indices);
+		}
+		return directions;
+	}
+
+	int ShDirections::getIcosphereSubdivisions(uint32_t targetCount)
+	{
+		// The vertex count grows about 4x per level, so the first level with at least half the target is the closest on a log scale
+		int subdivisions = 0;
+		while (subdivisions < MAX_ICOSPHERE_SUBDIVISIONS
+			&& static_cast<double>(getIcosphereVertexCount(subdivisions)) * 2.0 < static_cast<double>(targetCount))
+		{
+			subdivisions++;
+		}
+		return subdivisions;
+	}
+
+	ShDirections ShDirections::sample(SamplingScheme scheme, uint32_t targetCount)
+	{
+		switch (scheme)
+		{
+		case FIBONACCI_LATTICE:
+			return fibonacciLattice(targetCount);
+		case HEALPIX:
+			return healpix(getHealpixNside(targetCount));
+		case ICOSPHERE:
+			return icosphere(getIcosphereSubdivisions(targetCount));
+		default:
+			return sphericalGrid(getGridResolution(targetCount));
+		}
+	}
+
+	uint32_t ShDirections::sampleCount(SamplingScheme scheme, uint32_t targetCount)
+	{
+		switch (scheme)
+		{
+		case FIBONACCI_LATTICE:
+			return targetCount;
+		case HEALPIX:
+			return 12 * static_cast<uint32_t>(getHealpixNside(targetCount)) * getHealpixNside(targetCount);
+		case ICOSPHERE:
+			return getIcosphereVertexCount(getIcosphereSubdivisions(targetCount));
+		default:
+			return static_cast<uint32_t>(getGridResolution(targetCount)) * getGridResolution(targetCount);
+		}
+	}
+
+	double ShDirections::getPhi(size_t index) const
+	{
+		double phi = std::atan2(static_cast<double>(y[index]), static_cast<double>(x[index]));
+		return phi < 0.0 ? phi + 2.0 * PI : phi;
+	}
+
+	double ShDirections::getTheta(size_t index) const
+	{
+		return std::acos(std::clamp(static_cast<double>(z[index]), -1.0, 1.0));
+	}
+
+	ShEvaluator::ShEvaluator(int order) : order{ order }
+	{
+		assert(order >= 0 && "The order of the spherical harmonics has to be non-negative!");
+
+		int coefficientCount = getCoefficientCount();
+		normalization.resize(coefficientCount);
+		recurrenceA.resize(coefficientCount);
+		recurrenceB.resize(coefficientCount);
+		legendreStart.resize(order + 1);
+
+		double doubleFactorial = 1.0;
+		for (int m = 0; m <= order; m++)
+		{
+			if (m > 0)
+			{
+				doubleFactorial *= 2 * m - 1;
+			}
+			legendreStart[m] = (m % 2 == 0) ? doubleFactorial : -doubleFactorial;
+
+			for (int l = m; l <= order; l++)
+			{
+				int index = getIndex(l, m);
+				double k = std::sqrt((2.0 * l + 1.0) / (4.0 * PI) * factorial(l - m) / factorial(l + m));
+				normalization[index] = (m == 0) ? k : std::sqrt(2.0) * k;
+
+				if (l >= m + 2)
+				{
+					recurrenceA[index] = (2.0 * l - 1.0) / (l - m);
+					recurrenceB[index] = -(l + m - 1.0) / (l - m);
+				}
+			}
+		}
+	}
+
+	void ShEvaluator::evaluate(const float* x, const float* y, const float* z, size_t count, float* out) const
+	{
+		evaluateBatch(x, y, z, count, out);
+	}
+
+	void ShEvaluator::evaluate(const double* x, const double* y, const double* z, size_t count, double* out) const
+	{
+		evaluateBatch(x, y, z, count, out);
+	}
+
+	std::vector<float> ShEvaluator::evaluate(const ShDirections& directions) const
+	{
+		std::vector<float> values(static_cast<size_t>(getCoefficientCount()) * directions.size());
+		evaluateBatch(directions.x.data(), directions.y.data(), directions.z.data(), directions.size(), values.data());
+		return values;
+	}
+
+	const char* ShEvaluator::getInstructionSet()
+	{
+#if defined(VVT_SH_AVX2)
+		return "AVX2";
+#elif defined(VVT_SH_SSE2)
+		return "SSE2";
+#else
+		return "Scalar";
+#endif
+	}
+
+	template <typename T>
+	void ShEvaluator::evaluateBatch(const T* x, const T* y, const T* z, size_t count, T* out) const
+	{
+		using V = typename NativeVec<T>::type;
+
+		// Full SIMD registers first, the remaining directions are evaluated one by one
+		size_t vectorEnd = count - count % V::width;
+		evaluateRange<V>(x, y, z, 0, vectorEnd, count, out);
+		evaluateRange<ScalarVec<T>>(x, y, z, vectorEnd, count, count, out);
+	}
+
+	/*
+	* Y_lm = K_lm * P_lm(z) * (cos(m phi) | sin(|m| phi)), and with P_lm(z) = Q_lm(z) * sin(theta)^m both
+	* sin(theta)^m cos(m phi) and sin(theta)^m sin(m phi) are the real and imaginary part of (x + iy)^m.
+	* The polynomials Q_lm follow from the usual recurrence:
+	*	Q_mm = (-1)^m (2m-1)!!
+	*	Q_(m+1)m = (2m+1) z Q_mm
+	*	Q_lm = ((2l-1) z Q_(l-1)m - (l+m-1) Q_(l-2)m) / (l-m)
+	*/
+	template <typename V, typename T>
+	void ShEvaluator::evaluateRange(const T* x, const T* y, const T* z, size_t begin, size_t end, size_t count, T* out) const
+	{
+		for (size_t i = begin; i < end; i += V::width)
+		{
+			V vx = V::load(x + i);
+			V vy = V::load(y + i);
+			V vz = V::load(z + i);
+
+			// Real and imaginary part of (x + iy)^m
+			V cosTerm = V::set(T(1));
+			V sinTerm = V::set(T(0));
+
+			for (int m = 0; m <= order; m++)
+			{
+				auto storeBasis = [&](int l, V legendre)
+				{
+					int index = getIndex(l, m);
+					V scaled = legendre * V::set(static_cast<T>(normalization[index]));
+					if (m == 0)
+					{
+						scaled.store(out + static_cast<size_t>(index) * count + i);
+					}
+					else
+					{
+						(scaled * cosTerm).store(out + static_cast<size_t>(index) * count + i);
+						(scaled * sinTerm).store(out + static_cast<size_t>(getIndex(l, -m)) * count + i);
+					}
+				};
+
+				V previous = V::set(static_cast<T>(legendreStart[m]));
+				storeBasis(m, previous);
+
+				if (m < order)
+				{
+					V current = V::set(static_cast<T>(2 * m + 1)) * vz * previous;
+					storeBasis(m + 1, current);
+
+					for (int l = m + 2; l <= order; l++)
+					{
+						int index = getIndex(l, m);
+						V next = V::set(static_cast<T>(recurrenceA[index])) * vz * current + V::set(static_cast<T>(recurrenceB[index])) * previous;
+						previous = current;
+						current = next;
+						storeBasis(l, current);
+					}
+				}
+
+				V nextCos = vx * cosTerm - vy * sinTerm;
+				sinTerm = vx * sinTerm + vy * cosTerm;
+				cosTerm = nextCos;
+			}
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "enums.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Unit directions stored as a structure of arrays, so the evaluator can load several consecutive
+	* directions into one SIMD register.
+	*/
+	struct ShDirections {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		size_t size() const { return x.size(); }
+		void reserve(size_t count);
+		void push_back(float dirX, float dirY, float dirZ);
+
+		// phi (outer) / theta (inner) grid, with directions as in sh::ToVector. Crowds the directions at the poles
+		static ShDirections sphericalGrid(int resolution);
+		// Golden angle spiral, exactly count directions of (almost) equal spacing
+		static ShDirections fibonacciLattice(uint32_t count);
+		// Centers of the 12 * nside^2 equal-area HEALPix pixels, ordered ring by ring from the north pole
+		static ShDirections healpix(int nside);
+		// The 10 * 4^subdivisions + 2 vertices of a subdivided icosahedron, optionally with its triangles (counter-clockwise from outside)
+		static ShDirections icosphere(int subdivisions, std::vector<uint32_t>* triangles = nullptr);
+		static int getIcosphereSubdivisions(uint32_t targetCount);
+		// Directions of a scheme, as close to targetCount as the scheme allows
+		static ShDirections sample(SamplingScheme scheme, uint32_t targetCount);
+		// Size of sample(scheme, targetCount) without generating it
+		static uint32_t sampleCount(SamplingScheme scheme, uint32_t targetCount);
+
+		// Angles of direction i, phi in [0, 2pi) and theta in [0, pi] as the spherical functions expect them
+		double getPhi(size_t index) const;
+		double getTheta(size_t index) const;
+	};
+
+	/*
+	* Evaluates all real spherical harmonics Y_lm up to a given order for a batch of directions in one pass.
+	* Uses the associated Legendre recurrence in z and the (x + iy)^m recurrence for the azimuthal part, so no
+	* transcendental functions are evaluated per direction. Results match sh::EvalSH (including the
+	* Condon-Shortley phase).
+	*
+	* The output is a structure of arrays: out[k * count + i] holds Y_k of direction i, with k = l(l+1)+m
+	* (the same indexing as sh::GetIndex).
+	*/
+	class ShEvaluator
+	{
+	public:
+		explicit ShEvaluator(int order);
+
+		int getOrder() const { return order; }
+		int getCoefficientCount() const { return (order + 1) * (order + 1); }
+
+		void evaluate(const float* x, const float* y, const float* z, size_t count, float* out) const;
+		void evaluate(const double* x, const double* y, const double* z, size_t count, double* out) const;
+		std::vector<float> evaluate(const ShDirections& directions) const;
+
+		// SIMD instruction set the evaluator was compiled for
+		static const char* getInstructionSet();
+
+	private:
+		template <typename V, typename T>
+		void evaluateRange(const T* x, const T* y, const T* z, size_t begin, size_t end, size_t count, T* out) const;
+
+		template <typename T>
+		void evaluateBatch(const T* x, const T* y, const T* z, size_t count, T* out) const;
+
+		int order;
+
+		// Indexed by l(l+1)+m for m >= 0
+		std::vector<double> normalization;	// K_lm, times sqrt(2) for m > 0
+		std::vector<double> recurrenceA;	// (2l-1)/(l-m)
+		std::vector<double> recurrenceB;	// -(l+m-1)/(l-m)
+		// Indexed by m
+		std::vector<double> legendreStart;	// (-1)^m (2m-1)!!
+	};
+}
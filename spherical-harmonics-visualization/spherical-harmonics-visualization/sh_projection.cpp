@@ -0,0 +1,212 @@
+#include "sh_projection.hpp"
+#include "sh_evaluator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <future>
+#include <random>
+#include <stdexcept>
+
+namespace vvt {
+
+	namespace {
+
+		const double PI = 3.14159265358979323846;
+
+		// Number of samples whose basis functions are evaluated in one batch
+		const size_t SAMPLE_BATCH_SIZE = 256;
+
+		// SplitMix64 finalizer, decorrelates the seeds of neighbouring chunks
+		uint64_t mixSeed(uint64_t value)
+		{
+			value += 0x9e3779b97f4a7c15ull;
+			value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+			value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+			return value ^ (value >> 31);
+		}
+
+		// Uniform double in [0, 1), independent of the standard library's distribution implementation
+		double uniformDouble(std::mt19937_64& rng)
+		{
+			return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+		}
+	}
+
+	ShProjector::ShProjector(VvtThreadPool& threadPool) : threadPool{ threadPool }
+	{
+	}
+
+	ShProjection ShProjector::project(ProjectionMethod method, const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t seed) const
+	{
+		switch (method)
+		{
+		case MONTE_CARLO:
+			return projectMonteCarlo(func, order, sampleCount, seed);
+		case GAUSS_LEGENDRE:
+			return projectGaussLegendre(func, order);
+		case LEBEDEV:
+			return projectLebedev(func, order);
+		default:
+			throw std::runtime_error("Unknown projection method!");
+		}
+	}
+
+	ShProjection ShProjector::projectMonteCarlo(const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t seed) const
+	{
+		assert(sampleCount > 0 && "Monte Carlo projection needs at least one sample!");
+
+		size_t chunkCount = (sampleCount + SAMPLES_PER_CHUNK - 1) / SAMPLES_PER_CHUNK;
+		std::vector<std::future<std::vector<double>>> partialSums;
+		partialSums.reserve(chunkCount);
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			size_t chunkSamples = std::min(SAMPLES_PER_CHUNK, sampleCount - chunk * SAMPLES_PER_CHUNK);
+			uint64_t chunkSeed = mixSeed(seed ^ mixSeed(chunk));
+			partialSums.push_back(threadPool.submit([&func, order, chunkSamples, chunkSeed]()
+			{
+				return projectMonteCarloChunk(func, order, chunkSamples, chunkSeed);
+			}));
+		}
+
+		// Reduce in chunk order, the summation order must not depend on which worker finished first
+		size_t coefficientCount = static_cast<size_t>((order + 1) * (order + 1));
+		std::vector<double> sums(2 * coefficientCount, 0.0);
+		for (auto& partialSum : partialSums)
+		{
+			std::vector<double> chunkSums = partialSum.get();
+			for (size_t k = 0; k < sums.size(); k++)
+			{
+				sums[k] += chunkSums[k];
+			}
+		}
+
+		// Uniform sampling of the sphere: pdf = 1 / 4pi
+		ShProjection projection{};
+		projection.coeffs.resize(coefficientCount);
+		double sampleAmount = static_cast<double>(sampleCount);
+		for (size_t k = 0; k < coefficientCount; k++)
+		{
+			double mean = sums[k] / sampleAmount;
+			double variance = std::max(0.0, sums[coefficientCount + k] / sampleAmount - mean * mean);
+			projection.coeffs[k] = 4.0 * PI * mean;
+			projection.errorEstimate = std::max(projection.errorEstimate, 4.0 * PI * std::sqrt(variance / sampleAmount));
+		}
+		projection.functionEvaluations = sampleCount;
+		projection.description = "Monte Carlo (" + std::to_string(sampleCount) + " samples)";
+		return projection;
+	}
+
+	ShProjection ShProjector::projectGaussLegendre(const sh::SphericalFunction& func, int order) const
+	{
+		// f * Y_lm has degree 2L for a function band-limited to order L, which L+1 nodes integrate exactly
+		ShQuadratureRule rule = ShQuadratureRule::gaussLegendre(order + 1);
+		ShQuadratureRule referenceRule = ShQuadratureRule::gaussLegendre(order + 2);
+
+		ShProjection projection{};
+		projection.coeffs = projectQuadrature(func, order, rule);
+		projection.errorEstimate = maxDifference(projection.coeffs, projectQuadrature(func, order, referenceRule));
+		projection.functionEvaluations = rule.size() + referenceRule.size();
+		projection.description = rule.name + " (" + std::to_string(rule.size()) + " points)";
+		return projection;
+	}
+
+	ShProjection ShProjector::projectLebedev(const sh::SphericalFunction& func, int order) const
+	{
+		ShQuadratureRule rule = ShQuadratureRule::lebedev(2 * order);
+
+		// Compare against a Gauss-Legendre rule of higher degree. Its nodes avoid the poles and axes the Lebedev
+		// rules share, which would otherwise hide the error of functions that are not smooth there
+		ShQuadratureRule referenceRule = ShQuadratureRule::gaussLegendre((rule.degree + 3) / 2);
+
+		ShProjection projection{};
+		projection.coeffs = projectQuadrature(func, order, rule);
+		projection.errorEstimate = maxDifference(projection.coeffs, projectQuadrature(func, order, referenceRule));
+		projection.functionEvaluations = rule.size() + referenceRule.size();
+		projection.description = rule.name + " points";
+		return projection;
+	}
+
+	std::vector<double> ShProjector::projectQuadrature(const sh::SphericalFunction& func, int order, const ShQuadratureRule& rule)
+	{
+		ShEvaluator evaluator{ order };
+		size_t coefficientCount = static_cast<size_t>(evaluator.getCoefficientCount());
+		size_t pointCount = rule.size();
+
+		std::vector<double> basisValues(coefficientCount * pointCount);
+		evaluator.evaluate(rule.x.data(), rule.y.data(), rule.z.data(), pointCount, basisValues.data());
+
+		std::vector<double> weightedValues(pointCount);
+		for (size_t i = 0; i < pointCount; i++)
+		{
+			weightedValues[i] = rule.weights[i] * func(rule.phi[i], rule.theta[i]);
+		}
+
+		std::vector<double> coeffs(coefficientCount, 0.0);
+		for (size_t k = 0; k < coefficientCount; k++)
+		{
+			for (size_t i = 0; i < pointCount; i++)
+			{
+				coeffs[k] += weightedValues[i] * basisValues[k * pointCount + i];
+			}
+		}
+		return coeffs;
+	}
+
+	double ShProjector::maxDifference(const std::vector<double>& a, const std::vector<double>& b)
+	{
+		double difference = 0.0;
+		for (size_t k = 0; k < a.size(); k++)
+		{
+			difference = std::max(difference, std::abs(a[k] - b[k]));
+		}
+		return difference;
+	}
+
+	std::vector<double> ShProjector::projectMonteCarloChunk(const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t chunkSeed)
+	{
+		ShEvaluator evaluator{ order };
+		size_t coefficientCount = static_cast<size_t>(evaluator.getCoefficientCount());
+		std::vector<double> sums(2 * coefficientCount, 0.0);
+
+		std::mt19937_64 rng{ chunkSeed };
+		std::vector<double> x(SAMPLE_BATCH_SIZE), y(SAMPLE_BATCH_SIZE), z(SAMPLE_BATCH_SIZE), values(SAMPLE_BATCH_SIZE);
+		std::vector<double> basisValues(coefficientCount * SAMPLE_BATCH_SIZE);
+
+		for (size_t begin = 0; begin < sampleCount; begin += SAMPLE_BATCH_SIZE)
+		{
+			size_t batchSize = std::min(SAMPLE_BATCH_SIZE, sampleCount - begin);
+			for (size_t i = 0; i < batchSize; i++)
+			{
+				// Uniformly distributed direction: cos(theta) uniform in [-1, 1], phi uniform in [0, 2pi)
+				double cosTheta = 1.0 - 2.0 * uniformDouble(rng);
+				double phi = 2.0 * PI * uniformDouble(rng);
+				double sinTheta = std::sqrt(std::max(0.0, 1.0 - cosTheta * cosTheta));
+
+				x[i] = std::cos(phi) * sinTheta;
+				y[i] = std::sin(phi) * sinTheta;
+				z[i] = cosTheta;
+				values[i] = func(phi, std::acos(cosTheta));
+			}
+
+			evaluator.evaluate(x.data(), y.data(), z.data(), batchSize, basisValues.data());
+			for (size_t k = 0; k < coefficientCount; k++)
+			{
+				const double* basis = &basisValues[k * batchSize];
+				double sum = 0.0;
+				double squaredSum = 0.0;
+				for (size_t i = 0; i < batchSize; i++)
+				{
+					double sample = values[i] * basis[i];
+					sum += sample;
+					squaredSum += sample * sample;
+				}
+				sums[k] += sum;
+				sums[coefficientCount + k] += squaredSum;
+			}
+		}
+		return sums;
+	}
+}
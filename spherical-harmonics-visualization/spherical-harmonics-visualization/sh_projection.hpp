@@ -0,0 +1,56 @@
+#pragma once
+#include "vvt_thread_pool.hpp"
+#include "sh_quadrature.hpp"
+#include "enums.hpp"
+
+// libs
+#include <spherical_harmonics.h>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vvt {
+
+	struct ShProjection {
+		std::vector<double> coeffs;		// Indexed by sh::GetIndex(l, m)
+		double errorEstimate = 0.0;		// Estimated max. absolute error of a single coefficient
+		size_t functionEvaluations = 0;
+		std::string description;
+	};
+
+	/*
+	* Projects spherical functions onto the SH basis, distributing the work over a thread pool.
+	*
+	* Monte Carlo samples are split into chunks of a fixed size. Every chunk draws its samples from its own RNG
+	* stream derived from (seed, chunk index) and the partial sums are reduced in chunk order, so the coefficients
+	* are bit-reproducible for a given seed, independent of the number of worker threads.
+	*
+	* Quadrature rules integrate band-limited functions exactly with a few dozen points. Their error is estimated
+	* by comparing against a rule of higher degree, for Monte Carlo the standard error of the estimator is used.
+	*/
+	class ShProjector
+	{
+	public:
+		static constexpr size_t SAMPLES_PER_CHUNK = 4096;
+
+		explicit ShProjector(VvtThreadPool& threadPool);
+
+		ShProjection project(ProjectionMethod method, const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t seed) const;
+
+		ShProjection projectMonteCarlo(const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t seed) const;
+		ShProjection projectGaussLegendre(const sh::SphericalFunction& func, int order) const;
+		ShProjection projectLebedev(const sh::SphericalFunction& func, int order) const;
+
+		static std::vector<double> projectQuadrature(const sh::SphericalFunction& func, int order, const ShQuadratureRule& rule);
+
+	private:
+		// Returns the sums of f * Y_k followed by the sums of (f * Y_k)^2
+		static std::vector<double> projectMonteCarloChunk(const sh::SphericalFunction& func, int order, size_t sampleCount, uint64_t chunkSeed);
+		static double maxDifference(const std::vector<double>& a, const std::vector<double>& b);
+
+		VvtThreadPool& threadPool;
+	};
+}
@@ -0,0 +1,180 @@
+#include "sh_quadrature.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace vvt {
+
+	namespace {
+
+		const double PI = 3.14159265358979323846;
+
+		struct LebedevOrbit {
+			double a, b, c;
+			double weight;	// Weight of a single point, the weights of all points of a rule sum to 1
+		};
+
+		struct LebedevRule {
+			int pointCount;
+			int degree;
+			std::vector<LebedevOrbit> orbits;
+		};
+
+		/*
+		* Lebedev rules up to degree 11 (V. I. Lebedev, 1976). Orbits are given by a generator point whose
+		* coordinates are permuted and sign-flipped by the octahedral group.
+		*/
+		const std::vector<LebedevRule>& lebedevRules()
+		{
+			static const double a2 = 1.0 / std::sqrt(2.0);
+			static const double a3 = 1.0 / std::sqrt(3.0);
+			static const double b1 = 1.0 / std::sqrt(11.0);
+			static const double b1m = std::sqrt(1.0 - 2.0 * b1 * b1);
+			static const double c1p = 0.4597008433809831;
+			static const double c1q = 0.8880738339771153;
+
+			static const std::vector<LebedevRule> rules{
+				{ 6, 3, { { 1.0, 0.0, 0.0, 1.0 / 6.0 } } },
+				{ 14, 5, { { 1.0, 0.0, 0.0, 1.0 / 15.0 }, { a3, a3, a3, 3.0 / 40.0 } } },
+				{ 26, 7, { { 1.0, 0.0, 0.0, 1.0 / 21.0 }, { 0.0, a2, a2, 4.0 / 105.0 }, { a3, a3, a3, 9.0 / 280.0 } } },
+				{ 38, 9, { { 1.0, 0.0, 0.0, 1.0 / 105.0 }, { a3, a3, a3, 9.0 / 280.0 }, { c1p, c1q, 0.0, 1.0 / 35.0 } } },
+				{ 50, 11, { { 1.0, 0.0, 0.0, 4.0 / 315.0 }, { 0.0, a2, a2, 64.0 / 2835.0 }, { a3, a3, a3, 27.0 / 1280.0 }, { b1, b1, b1m, 14641.0 / 725760.0 } } },
+			};
+			return rules;
+		}
+
+		// Legendre polynomial P_n(x) and its derivative
+		void legendre(int n, double x, double& value, double& derivative)
+		{
+			double previous = 1.0;
+			value = x;
+			for (int k = 2; k <= n; k++)
+			{
+				double next = ((2.0 * k - 1.0) * x * value - (k - 1.0) * previous) / k;
+				previous = value;
+				value = next;
+			}
+			derivative = n * (x * value - previous) / (x * x - 1.0);
+		}
+	}
+
+	ShQuadratureRule ShQuadratureRule::gaussLegendre(int nodeCount)
+	{
+		assert(nodeCount > 0 && "A Gauss-Legendre rule needs at least one node!");
+
+		ShQuadratureRule rule{};
+		rule.name = "Gauss-Legendre x trapezoid";
+		rule.degree = 2 * nodeCount - 1;
+
+		int phiCount = 2 * nodeCount - 1;
+		for (int i = 0; i < nodeCount; i++)
+		{
+			// Newton iteration on P_n, starting from the Chebyshev approximation of the root
+			double z = std::cos(PI * (i + 0.75) / (nodeCount + 0.5));
+			double value = 0.0;
+			double derivative = 1.0;
+			if (nodeCount > 1)
+			{
+				for (int iteration = 0; iteration < 100; iteration++)
+				{
+					legendre(nodeCount, z, value, derivative);
+					double step = value / derivative;
+					z -= step;
+					if (std::abs(step) < 1e-16)
+					{
+						break;
+					}
+				}
+				legendre(nodeCount, z, value, derivative);
+			}
+			else
+			{
+				z = 0.0;
+				derivative = 1.0;
+			}
+			double thetaWeight = 2.0 / ((1.0 - z * z) * derivative * derivative);
+
+			double sinTheta = std::sqrt(std::max(0.0, 1.0 - z * z));
+			for (int j = 0; j < phiCount; j++)
+			{
+				double phi = 2.0 * PI * j / phiCount;
+				rule.addPoint(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, z, thetaWeight * 2.0 * PI / phiCount);
+			}
+		}
+		return rule;
+	}
+
+	ShQuadratureRule ShQuadratureRule::lebedev(int minDegree)
+	{
+		for (const auto& lebedevRule : lebedevRules())
+		{
+			if (lebedevRule.degree < minDegree)
+			{
+				continue;
+			}
+
+			ShQuadratureRule rule{};
+			rule.name = "Lebedev " + std::to_string(lebedevRule.pointCount);
+			rule.degree = lebedevRule.degree;
+			for (const auto& orbit : lebedevRule.orbits)
+			{
+				rule.addOctahedralOrbit(orbit.a, orbit.b, orbit.c, 4.0 * PI * orbit.weight);
+			}
+			assert(rule.size() == static_cast<size_t>(lebedevRule.pointCount) && "Lebedev orbit generated the wrong amount of points!");
+			return rule;
+		}
+		throw std::runtime_error("No Lebedev rule of degree " + std::to_string(minDegree) + " available!");
+	}
+
+	int ShQuadratureRule::maxLebedevDegree()
+	{
+		return lebedevRules().back().degree;
+	}
+
+	void ShQuadratureRule::addPoint(double dirX, double dirY, double dirZ, double weight)
+	{
+		x.push_back(dirX);
+		y.push_back(dirY);
+		z.push_back(dirZ);
+		weights.push_back(weight);
+
+		// Spherical coordinates as expected by sh::SphericalFunction, phi in [0, 2pi)
+		double pointPhi = std::atan2(dirY, dirX);
+		phi.push_back(pointPhi < 0.0 ? pointPhi + 2.0 * PI : pointPhi);
+		theta.push_back(std::acos(std::clamp(dirZ, -1.0, 1.0)));
+	}
+
+	/* Adds all distinct points generated by permuting and sign-flipping (a, b, c) */
+	void ShQuadratureRule::addOctahedralOrbit(double a, double b, double c, double weight)
+	{
+		std::array<double, 3> generator{ a, b, c };
+		std::sort(generator.begin(), generator.end());
+
+		std::vector<std::array<double, 3>> orbit;
+		do
+		{
+			for (int signs = 0; signs < 8; signs++)
+			{
+				std::array<double, 3> point{
+					(signs & 1) ? -generator[0] : generator[0],
+					(signs & 2) ? -generator[1] : generator[1],
+					(signs & 4) ? -generator[2] : generator[2] };
+
+				// Sign flips of zero coordinates generate duplicates
+				if (std::find(orbit.begin(), orbit.end(), point) == orbit.end())
+				{
+					orbit.push_back(point);
+				}
+			}
+		} while (std::next_permutation(generator.begin(), generator.end()));
+
+		for (const auto& point : orbit)
+		{
+			addPoint(point[0], point[1], point[2], weight);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Quadrature rule on the unit sphere. Directions are stored as a structure of arrays (as in sh::ToVector),
+	* together with their spherical coordinates for evaluating sh::SphericalFunction. The weights sum to 4pi.
+	*/
+	struct ShQuadratureRule {
+		std::string name;
+		int degree = 0;	// Spherical polynomials up to this degree are integrated exactly
+		std::vector<double> x;
+		std::vector<double> y;
+		std::vector<double> z;
+		std::vector<double> phi;
+		std::vector<double> theta;
+		std::vector<double> weights;
+
+		size_t size() const { return weights.size(); }
+
+		/*
+		* Product rule of n Gauss-Legendre nodes in cos(theta) and 2n-1 equidistant nodes in phi (trapezoid rule),
+		* exact up to degree 2n-1. A band-limited function of order L is projected exactly with n = L+1.
+		*/
+		static ShQuadratureRule gaussLegendre(int nodeCount);
+
+		// Smallest available Lebedev rule that is exact up to the given degree (6, 14, 26, 38 or 50 points)
+		static ShQuadratureRule lebedev(int minDegree);
+		static int maxLebedevDegree();
+
+	private:
+		void addPoint(double dirX, double dirY, double dirZ, double weight);
+		void addOctahedralOrbit(double a, double b, double c, double weight);
+	};
+}
@@ -0,0 +1,168 @@
+#include "sh_rotation.hpp"
+
+// std
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+namespace vvt {
+
+	namespace {
+
+		int getIndex(int l, int m)
+		{
+			return l * (l + 1) + m;
+		}
+
+		// Band 1 basis functions are proportional to y, z and x (for m = -1, 0, 1)
+		int axisOfDegree(int m)
+		{
+			const int axes[3] = { 1, 2, 0 };
+			return axes[m + 1];
+		}
+	}
+
+	/*
+	* J. Ivanic, K. Ruedenberg: "Rotation Matrices for Real Spherical Harmonics. Direct Determination by Recursion"
+	* (1996, with the 1998 corrections). The recurrence is formulated without the Condon-Shortley phase, which is
+	* applied afterwards as a (-1)^(m+n) sign per matrix entry.
+	*/
+	ShRotation::ShRotation(int order, const double rotationMatrix[3][3]) : order{ order }
+	{
+		assert(order >= 0 && "The order of the spherical harmonics has to be non-negative!");
+
+		bands.resize(order + 1);
+		bands[0] = { 1.0 };
+		if (order == 0)
+		{
+			return;
+		}
+
+		bands[1].resize(9);
+		for (int m = -1; m <= 1; m++)
+		{
+			for (int n = -1; n <= 1; n++)
+			{
+				bandValue(1, m, n) = rotationMatrix[axisOfDegree(m)][axisOfDegree(n)];
+			}
+		}
+
+		for (int l = 2; l <= order; l++)
+		{
+			bands[l].resize(static_cast<size_t>((2 * l + 1) * (2 * l + 1)));
+			for (int m = -l; m <= l; m++)
+			{
+				for (int n = -l; n <= l; n++)
+				{
+					double value = u(l, m, n);
+					if (m != 0)
+					{
+						value += w(l, m, n);
+					}
+					bandValue(l, m, n) = value + v(l, m, n);
+				}
+			}
+		}
+
+		// Condon-Shortley phase, only after the recurrence is done since it reads the unsigned previous bands
+		for (int l = 1; l <= order; l++)
+		{
+			for (int m = -l; m <= l; m++)
+			{
+				for (int n = -l; n <= l; n++)
+				{
+					if ((std::abs(m) + std::abs(n)) % 2 == 1)
+					{
+						bandValue(l, m, n) = -bandValue(l, m, n);
+					}
+				}
+			}
+		}
+	}
+
+	void ShRotation::apply(const std::vector<double>& coeffs, std::vector<double>& result) const
+	{
+		assert(coeffs.size() >= static_cast<size_t>((order + 1) * (order + 1)) && "Not enough coefficients for the order of the rotation!");
+
+		result.assign(coeffs.size(), 0.0);
+		for (int l = 0; l <= order; l++)
+		{
+			for (int m = -l; m <= l; m++)
+			{
+				double sum = 0.0;
+				for (int n = -l; n <= l; n++)
+				{
+					sum += bandValue(l, m, n) * coeffs[getIndex(l, n)];
+				}
+				result[getIndex(l, m)] = sum;
+			}
+		}
+	}
+
+	double ShRotation::p(int i, int l, int a, int b) const
+	{
+		if (b == l)
+		{
+			return bandValue(1, i, 1) * bandValue(l - 1, a, l - 1) - bandValue(1, i, -1) * bandValue(l - 1, a, -l + 1);
+		}
+		else if (b == -l)
+		{
+			return bandValue(1, i, 1) * bandValue(l - 1, a, -l + 1) + bandValue(1, i, -1) * bandValue(l - 1, a, l - 1);
+		}
+		return bandValue(1, i, 0) * bandValue(l - 1, a, b);
+	}
+
+	double ShRotation::u(int l, int m, int n) const
+	{
+		double denominator = (std::abs(n) == l) ? (2.0 * l) * (2.0 * l - 1.0) : (l + n) * (l - n);
+		double factor = std::sqrt((l + m) * (l - m) / denominator);
+		return factor == 0.0 ? 0.0 : factor * p(0, l, m, n);
+	}
+
+	double ShRotation::v(int l, int m, int n) const
+	{
+		double denominator = (std::abs(n) == l) ? (2.0 * l) * (2.0 * l - 1.0) : (l + n) * (l - n);
+		int absM = std::abs(m);
+		double delta = (m == 0) ? 1.0 : 0.0;
+		double factor = 0.5 * std::sqrt((1.0 + delta) * (l + absM - 1.0) * (l + absM) / denominator) * (1.0 - 2.0 * delta);
+		if (factor == 0.0)
+		{
+			return 0.0;
+		}
+
+		double term;
+		if (m == 0)
+		{
+			term = p(1, l, 1, n) + p(-1, l, -1, n);
+		}
+		else if (m > 0)
+		{
+			term = (m == 1)
+				? std::sqrt(2.0) * p(1, l, 0, n)
+				: p(1, l, m - 1, n) - p(-1, l, -m + 1, n);
+		}
+		else
+		{
+			term = (m == -1)
+				? std::sqrt(2.0) * p(-1, l, 0, n)
+				: p(1, l, m + 1, n) + p(-1, l, -m - 1, n);
+		}
+		return factor * term;
+	}
+
+	double ShRotation::w(int l, int m, int n) const
+	{
+		double denominator = (std::abs(n) == l) ? (2.0 * l) * (2.0 * l - 1.0) : (l + n) * (l - n);
+		int absM = std::abs(m);
+		double factor = -0.5 * std::sqrt((l - absM - 1.0) * (l - absM) / denominator);
+		if (factor == 0.0)
+		{
+			return 0.0;
+		}
+
+		double term = (m > 0)
+			? p(1, l, m + 1, n) + p(-1, l, -m - 1, n)
+			: p(1, l, m - 1, n) - p(-1, l, -m + 1, n);
+		return factor * term;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// std
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Rotation of real SH coefficients, built per band with the Ivanic/Ruedenberg recurrence from a 3x3 rotation
+	* matrix. Band l is a (2l+1)x(2l+1) matrix computed from band l-1 and band 1, so building all bands up to order L
+	* costs O(L^3) and no function has to be re-projected or re-evaluated.
+	*
+	* For a rotation matrix R the rotated coefficients describe f'(x) = f(R^T x), i.e. the function rotated the same
+	* way R rotates points. Coefficients use the sh::GetIndex layout and the Condon-Shortley phase of sh::EvalSH.
+	*/
+	class ShRotation
+	{
+	public:
+		// rotationMatrix[row][column]
+		ShRotation(int order, const double rotationMatrix[3][3]);
+
+		int getOrder() const { return order; }
+
+		void apply(const std::vector<double>& coeffs, std::vector<double>& result) const;
+
+	private:
+		double bandValue(int l, int m, int n) const { return bands[l][(m + l) * (2 * l + 1) + (n + l)]; }
+		double& bandValue(int l, int m, int n) { return bands[l][(m + l) * (2 * l + 1) + (n + l)]; }
+
+		// Helper terms of the recurrence
+		double p(int i, int l, int a, int b) const;
+		double u(int l, int m, int n) const;
+		double v(int l, int m, int n) const;
+		double w(int l, int m, int n) const;
+
+		int order;
+		std::vector<std::vector<double>> bands;
+	};
+}
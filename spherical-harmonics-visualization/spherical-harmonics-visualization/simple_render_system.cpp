@@ -1,10 +1,15 @@
 #include "simple_render_system.hpp"
+#include "vvt_profiler.hpp"
+#include "vvt_swap_chain.hpp"
 
 // std
 #include <cassert>
 #include <stdexcept>
 #include <array>
 #include <chrono>
+#include <cstddef>
+#include <future>
+#include <iostream>
 #include <math.h>
 
 
@@ -16,15 +21,26 @@
 
 namespace vvt {
 
-	SimpleRenderSystem::SimpleRenderSystem(VvtDevice &device, VkRenderPass sceneRenderPass,  VkRenderPass skyboxRenderPass, VkDescriptorSetLayout globalSetLayout) : vvtDevice{device}
+	SimpleRenderSystem::SimpleRenderSystem(VvtDevice &device, VvtThreadPool& threadPool, VkRenderPass sceneRenderPass,  VkRenderPass skyboxRenderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout shCoefficientSetLayout, VvtModel::VertexLayout pointModelLayout) : vvtDevice{device}, threadPool{threadPool}, pointModelLayout{pointModelLayout}
 	{
+		createRecordingPools();
+		createFrameCommands();
 		createPipelineLayout(globalSetLayout);
 		createPipeline(sceneRenderPass);
+		createPointPipelineLayout(globalSetLayout);
+		createReconstructionPipelineLayout(globalSetLayout, shCoefficientSetLayout);
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
+		// Destroying a pool frees all command buffers allocated from it
+		for (auto& recordingPool : recordingPools)
+		{
+			vkDestroyCommandPool(vvtDevice.device(), recordingPool.pool, nullptr);
+		}
 		vkDestroyPipelineLayout(vvtDevice.device(), pipelineLayout, nullptr);
+		vkDestroyPipelineLayout(vvtDevice.device(), pointPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(vvtDevice.device(), reconstructionPipelineLayout, nullptr);
 	}
 
 	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
@@ -60,9 +76,391 @@ namespace vvt {
 		vvtPipeline = std::make_unique<VvtPipeline>(vvtDevice, "../Shaders/simple_shader.vert.spv", "../Shaders/simple_shader.frag.spv", pipelineConfig);
 	}
 
+	void SimpleRenderSystem::createPointPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(PointPushConstant);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(vvtDevice.device(), &pipelineLayoutInfo, nullptr, &pointPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create point pipeline layout!");
+		}
+	}
+
+	void SimpleRenderSystem::createReconstructionPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout shCoefficientSetLayout)
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(PointPushConstant);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, shCoefficientSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(vvtDevice.device(), &pipelineLayoutInfo, nullptr, &reconstructionPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create reconstruction pipeline layout!");
+		}
+	}
+
+	std::unique_ptr<VvtPipeline> SimpleRenderSystem::createPointStylePipeline(const PointStyle& style, VisualizationMode mode, bool reconstruction, VkRenderPass renderPass)
+	{
+		VkPipelineLayout layout = reconstruction ? reconstructionPipelineLayout : pointPipelineLayout;
+		assert(layout != nullptr && "Pipeline layout should be created before pipeline creation!");
+
+		// Shaders ignore the constants they don't declare, e.g. the point shader has no SH order
+		PointSpecialization specialization{ style.reconstructionOrder, static_cast<int32_t>(style.colorMode), style.lighting ? VK_TRUE : VK_FALSE, mode == DISPLACED_SURFACE ? VK_TRUE : VK_FALSE };
+		std::array<VkSpecializationMapEntry, 4> mapEntries{ {
+			{ 0, offsetof(PointSpecialization, shOrder), sizeof(int32_t) },
+			{ 1, offsetof(PointSpecialization, colorMode), sizeof(int32_t) },
+			{ 2, offsetof(PointSpecialization, lighting), sizeof(VkBool32) },
+			{ 3, offsetof(PointSpecialization, displace), sizeof(VkBool32) },
+		} };
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+		specializationInfo.pMapEntries = mapEntries.data();
+		specializationInfo.dataSize = sizeof(specialization);
+		specializationInfo.pData = &specialization;
+
+		// The reconstruction has the same vertex input as the function, it ignores the sample values
+		PipelineConfigInfo pipelineConfig{};
+		if (mode == POINT_CLOUD)
+		{
+			pointPipelineConfigInfo(pipelineConfig);
+		}
+		else
+		{
+			surfacePipelineConfigInfo(pipelineConfig);
+		}
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = layout;
+		pipelineConfig.vertexSpecializationInfo = &specializationInfo;
+
+		if (mode == POINT_CLOUD)
+		{
+			std::string shaderName = reconstruction ? "sh_reconstruction_shader" : "point_shader";
+			return std::make_unique<VvtPipeline>(vvtDevice, getPointVertexShaderPath(shaderName), "../Shaders/point_shader.frag.spv", pipelineConfig);
+		}
+
+		// Surfaces are lit per fragment
+		pipelineConfig.fragmentSpecializationInfo = &specializationInfo;
+		std::string vertexShaderPath = reconstruction ? "../Shaders/surface_reconstruction_shader.vert.spv" : "../Shaders/surface_shader.vert.spv";
+		return std::make_unique<VvtPipeline>(vvtDevice, vertexShaderPath, "../Shaders/surface_shader.frag.spv", pipelineConfig);
+	}
+
+	void SimpleRenderSystem::pointPipelineConfigInfo(PipelineConfigInfo& configInfo) const
+	{
+		VvtPipeline::defaultPipelineConfigInfo(configInfo);
+
+		// Per-vertex data of the point model + per-instance data of the sample points
+		configInfo.bindingDescriptions = pointModelLayout.getBindingDescriptions();
+		configInfo.attributeDescriptions = pointModelLayout.getAttributeDescriptions();
+		auto instanceBindings = PointInstance::getBindingDescriptions();
+		auto instanceAttributes = PointInstance::getAttributeDescriptions();
+		configInfo.bindingDescriptions.insert(configInfo.bindingDescriptions.end(), instanceBindings.begin(), instanceBindings.end());
+		configInfo.attributeDescriptions.insert(configInfo.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+	}
+
+	void SimpleRenderSystem::surfacePipelineConfigInfo(PipelineConfigInfo& configInfo)
+	{
+		VvtPipeline::defaultPipelineConfigInfo(configInfo);
+		configInfo.bindingDescriptions = PointInstance::getBindingDescriptions(VK_VERTEX_INPUT_RATE_VERTEX);
+		configInfo.attributeDescriptions = PointInstance::getAttributeDescriptions();
+	}
+
+	uint64_t SimpleRenderSystem::getPointStyleKey(const PointStyle& style, VisualizationMode mode)
+	{
+		return static_cast<uint64_t>(style.reconstructionOrder)
+			| (static_cast<uint64_t>(style.colorMode) << 8)
+			| (static_cast<uint64_t>(style.lighting) << 16)
+			| (static_cast<uint64_t>(mode) << 24);
+	}
+
+	VvtPipeline& SimpleRenderSystem::getPointPipeline(VisualizationMode mode)
+	{
+		// The function's shaders don't use the SH order, so they don't need a variant per order
+		PointStyle style = pointStyle;
+		style.reconstructionOrder = 0;
+		return pointPipelines.get(getPointStyleKey(style, mode), recordingRenderPass, [this, style, mode](VkRenderPass renderPass) { return createPointStylePipeline(style, mode, false, renderPass); });
+	}
+
+	VvtPipeline& SimpleRenderSystem::getReconstructionPipeline(VisualizationMode mode)
+	{
+		PointStyle style = pointStyle;
+		return reconstructionPipelines.get(getPointStyleKey(style, mode), recordingRenderPass, [this, style, mode](VkRenderPass renderPass) { return createPointStylePipeline(style, mode, true, renderPass); });
+	}
+
+	// The reconstruction shaders hold the coefficients of up to order 3 in fixed size arrays (16 values in vec4s)
+	static_assert(BASIS_FUNCTION_MAX_ORDER <= 3, "The SH reconstruction shaders only evaluate up to order 3");
+
+	void SimpleRenderSystem::setPointStyle(const PointStyle& style)
+	{
+		pointStyle = style;
+		pointStyle.reconstructionOrder = glm::clamp(style.reconstructionOrder, 0, BASIS_FUNCTION_MAX_ORDER);
+		pipelineRevision++;
+	}
+
+	uint64_t SimpleRenderSystem::getSphereFunctionRevision(const SphereContainer& sphereFunction) const
+	{
+		return sphereFunction.getRevision() ^ (pipelineRevision << 32);
+	}
+
+	std::string SimpleRenderSystem::getPointVertexShaderPath(const std::string& shaderName) const
+	{
+		// Compact variants are compiled from the same source with COMPACT_VERTEX defined, see compile.bat
+		return "../Shaders/" + shaderName + (pointModelLayout.compact ? "_compact" : "") + ".vert.spv";
+	}
+
+	void SimpleRenderSystem::watchShaders(VvtShaderManager& shaderManager) const
+	{
+		shaderManager.watch("../Shaders/simple_shader.vert.spv", "../Shaders/simple_shader.vert");
+		shaderManager.watch("../Shaders/simple_shader.frag.spv", "../Shaders/simple_shader.frag");
+		shaderManager.watch("../Shaders/point_shader.frag.spv", "../Shaders/point_shader.frag");
+
+		// Only the vertex shaders of the point model's layout are in use
+		std::vector<std::string> defines;
+		if (pointModelLayout.compact)
+		{
+			defines.push_back("COMPACT_VERTEX");
+		}
+		for (const std::string shaderName : { "point_shader", "sh_reconstruction_shader" })
+		{
+			shaderManager.watch(getPointVertexShaderPath(shaderName), "../Shaders/" + shaderName + ".vert", defines);
+		}
+
+		shaderManager.watch("../Shaders/surface_shader.vert.spv", "../Shaders/surface_shader.vert");
+		shaderManager.watch("../Shaders/surface_reconstruction_shader.vert.spv", "../Shaders/surface_shader.vert", { "RECONSTRUCTION" });
+		shaderManager.watch("../Shaders/surface_shader.frag.spv", "../Shaders/surface_shader.frag");
+	}
+
+	void SimpleRenderSystem::reloadPipelines(VkRenderPass renderPass)
+	{
+		VVT_PROFILE_FUNCTION();
+		std::vector<std::unique_ptr<VvtPipeline>> retired;
+
+		std::unique_ptr<VvtPipeline> previous = std::move(vvtPipeline);
+		try
+		{
+			createPipeline(renderPass);
+			retired.push_back(std::move(previous));
+		}
+		catch (const std::exception& e)
+		{
+			vvtPipeline = std::move(previous);
+			std::cerr << "Failed to reload the game object pipeline: " << e.what() << std::endl;
+		}
+
+		for (VvtPipelineRegistry* registry : { &pointPipelines, &reconstructionPipelines })
+		{
+			try
+			{
+				registry->recreate(renderPass, retired);
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Failed to reload the point style pipelines: " << e.what() << std::endl;
+			}
+		}
+
+		for (auto& pipeline : retired)
+		{
+			retiredPipelines.push_back({ std::move(pipeline), frameCount });
+		}
+
+		// Everything recorded so far binds the old pipelines
+		invalidations++;
+		pipelineRevision++;
+	}
+
 	// TODO: State update of objects should be handled somewhere else!
 	// Render loop
-	void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet, std::vector<VvtGameObject> &gameObjects, std::vector<SphereContainer>& sphereFunctions, const VvtCamera& camera, const float frameDeltaTime, VvtGameObject* viewerObj)
+	void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent, std::vector<VvtGameObject> &gameObjects, std::vector<SphereContainer>& sphereFunctions, const VvtCamera& camera, const float frameDeltaTime, VvtGameObject* viewerObj, VvtGpuProfiler& gpuProfiler)
+	{
+		// Per-frame data lives in buffers, the recorded commands only reference them
+		for (auto& sph : sphereFunctions) {
+			sph.updateCoefficientBuffer(frameIndex);
+		}
+
+		// The frame slot's fence was waited on, so none of its secondary command buffers is in use anymore
+		FrameCommands& frame = frameCommands[frameIndex];
+		recordingRenderPass = renderPass;
+
+		// Once every frame slot was waited on since a pipeline was retired, no submitted frame references it anymore
+		frameCount++;
+		while (!retiredPipelines.empty() && frameCount >= retiredPipelines.front().retiredAtFrame + VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
+		{
+			retiredPipelines.erase(retiredPipelines.begin());
+		}
+
+		uint64_t sceneRevision = invalidations ^ (static_cast<uint64_t>(gameObjects.size()) << 32);
+		bool sceneUpToDate = frame.scene.isUpToDate(&gameObjects, sceneRevision, renderPass, extent, globalDescriptorSet)
+			&& gpuProfiler.replayCapture(frame.profilerScopes);
+		if (!sceneUpToDate) {
+			frame.profilerScopes = gpuProfiler.beginCapture();
+
+			beginSecondary(frame.scene.commandBuffer, extent);
+			recordGameObjects(frame.scene.commandBuffer, globalDescriptorSet, gameObjects);
+			gpuProfiler.beginScope(frame.scene.commandBuffer, "Spherical functions");
+			endSecondary(frame.scene.commandBuffer);
+
+			beginSecondary(frame.sceneEnd, extent);
+			gpuProfiler.endScope(frame.sceneEnd);
+			endSecondary(frame.sceneEnd);
+
+			gpuProfiler.endCapture(frame.profilerScopes);
+
+			frame.scene.recorded = true;
+			frame.scene.source = &gameObjects;
+			frame.scene.revision = sceneRevision;
+			frame.scene.renderPass = renderPass;
+			frame.scene.extent = extent;
+			frame.scene.globalDescriptorSet = globalDescriptorSet;
+			sceneRecordCount += 2;
+		}
+
+		// Creating missing variants here keeps the recording threads from waiting on each other in the registry
+		activePointPipelines.fill(nullptr);
+		activeReconstructionPipelines.fill(nullptr);
+		for (const auto& sphereFunction : sphereFunctions) {
+			VisualizationMode mode = sphereFunction.getVisualizationMode();
+			if (activePointPipelines[mode] == nullptr) {
+				activePointPipelines[mode] = &getPointPipeline(mode);
+				activeReconstructionPipelines[mode] = &getReconstructionPipeline(mode);
+			}
+		}
+		recordSphereFunctions(frame, globalDescriptorSet, frameIndex, extent, sphereFunctions);
+
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+		secondaryCommandBuffers.reserve(frame.sphereFunctions.size() + 2);
+		secondaryCommandBuffers.push_back(frame.scene.commandBuffer);
+		for (const auto& cached : frame.sphereFunctions) {
+			secondaryCommandBuffers.push_back(cached.commandBuffer);
+		}
+		secondaryCommandBuffers.push_back(frame.sceneEnd);
+
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+	}
+
+	void SimpleRenderSystem::invalidateSceneCommands()
+	{
+		invalidations++;
+	}
+
+	bool SimpleRenderSystem::CachedCommands::isUpToDate(const void* source, uint64_t revision, VkRenderPass renderPass, VkExtent2D extent, VkDescriptorSet globalDescriptorSet) const
+	{
+		// A recreated swap chain may keep its extent, but the commands still reference its old render pass
+		return recorded
+			&& this->source == source
+			&& this->revision == revision
+			&& this->renderPass == renderPass
+			&& this->extent.width == extent.width && this->extent.height == extent.height
+			&& this->globalDescriptorSet == globalDescriptorSet;
+	}
+
+	void SimpleRenderSystem::createRecordingPools()
+	{
+		recordingPools.resize(threadPool.getThreadCount() + 1);
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = vvtDevice.findPhysicalQueueFamilies().graphicsFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		for (auto& recordingPool : recordingPools) {
+			if (vkCreateCommandPool(vvtDevice.device(), &poolInfo, nullptr, &recordingPool.pool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create recording command pool!");
+			}
+		}
+	}
+
+	void SimpleRenderSystem::createFrameCommands()
+	{
+		uint32_t mainPool = static_cast<uint32_t>(recordingPools.size() - 1);
+
+		frameCommands.resize(VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& frame : frameCommands) {
+			frame.scene.commandBuffer = acquireCommandBuffer(mainPool);
+			frame.scene.pool = mainPool;
+			frame.sceneEnd = acquireCommandBuffer(mainPool);
+		}
+	}
+
+	VkCommandBuffer SimpleRenderSystem::acquireCommandBuffer(uint32_t poolIndex)
+	{
+		RecordingPool& recordingPool = recordingPools[poolIndex];
+		if (!recordingPool.freeCommandBuffers.empty()) {
+			VkCommandBuffer commandBuffer = recordingPool.freeCommandBuffers.back();
+			recordingPool.freeCommandBuffers.pop_back();
+			return commandBuffer;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandPool = recordingPool.pool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(vvtDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate secondary command buffer!");
+		}
+		return commandBuffer;
+	}
+
+	void SimpleRenderSystem::beginSecondary(VkCommandBuffer commandBuffer, VkExtent2D extent)
+	{
+		// Secondary command buffers continue the scene render pass of any framebuffer
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = recordingRenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording secondary command buffer!");
+		}
+
+		// Dynamic state is not inherited from the primary command buffer
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void SimpleRenderSystem::endSecondary(VkCommandBuffer commandBuffer)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record secondary command buffer!");
+		}
+	}
+
+	void SimpleRenderSystem::recordGameObjects(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet, std::vector<VvtGameObject>& gameObjects)
 	{
 		// ===========
 		// Draw scene
@@ -120,9 +518,102 @@ namespace vvt {
 				child.model->draw(commandBuffer);
 			}
 		}
+	}
 
-		for (auto& sph : sphereFunctions) {
-			sph.render(commandBuffer, pipelineLayout);
+	/* Records the point cloud, basis functions and reconstruction of one spherical function, may run on any worker */
+	void SimpleRenderSystem::recordSphereFunction(CachedCommands& cached, uint32_t poolIndex, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent, SphereContainer& sphereFunction)
+	{
+		VVT_PROFILE_FUNCTION();
+		VkCommandBuffer commandBuffer = acquireCommandBuffer(poolIndex);
+		beginSecondary(commandBuffer, extent);
+
+		// Bound state doesn't carry over between secondary command buffers, every one binds its own pipelines
+		VisualizationMode mode = sphereFunction.getVisualizationMode();
+		activePointPipelines[mode]->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pointPipelineLayout,
+			0, 1,
+			&globalDescriptorSet, 0,
+			nullptr);
+		sphereFunction.render(commandBuffer, pointPipelineLayout);
+
+		activeReconstructionPipelines[mode]->bind(commandBuffer);
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			reconstructionPipelineLayout,
+			0, 1,
+			&globalDescriptorSet, 0,
+			nullptr);
+		sphereFunction.renderReconstruction(commandBuffer, reconstructionPipelineLayout, frameIndex);
+
+		endSecondary(commandBuffer);
+
+		// The previous command buffer is handed back to its pool by the main thread once all recording is done
+		cached.commandBuffer = commandBuffer;
+		cached.pool = poolIndex;
+		cached.recorded = true;
+		cached.source = &sphereFunction;
+		cached.revision = getSphereFunctionRevision(sphereFunction);
+		cached.renderPass = recordingRenderPass;
+		cached.extent = extent;
+		cached.globalDescriptorSet = globalDescriptorSet;
+		sceneRecordCount++;
+	}
+
+	void SimpleRenderSystem::recordSphereFunctions(FrameCommands& frame, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent, std::vector<SphereContainer>& sphereFunctions)
+	{
+		// Command buffers of removed functions are recycled right away, this frame slot doesn't use them anymore
+		for (size_t i = sphereFunctions.size(); i < frame.sphereFunctions.size(); i++) {
+			if (frame.sphereFunctions[i].commandBuffer != VK_NULL_HANDLE) {
+				recordingPools[frame.sphereFunctions[i].pool].freeCommandBuffers.push_back(frame.sphereFunctions[i].commandBuffer);
+			}
+		}
+		frame.sphereFunctions.resize(sphereFunctions.size());
+
+		std::vector<size_t> outdated;
+		std::vector<CachedCommands> retired;
+		for (size_t i = 0; i < sphereFunctions.size(); i++) {
+			CachedCommands& cached = frame.sphereFunctions[i];
+			if (!cached.isUpToDate(&sphereFunctions[i], getSphereFunctionRevision(sphereFunctions[i]), recordingRenderPass, extent, globalDescriptorSet)) {
+				outdated.push_back(i);
+				retired.push_back(cached);
+			}
+		}
+
+		uint32_t mainPool = static_cast<uint32_t>(recordingPools.size() - 1);
+		if (outdated.size() == 1) {
+			// Not worth a round trip through the thread pool
+			recordSphereFunction(frame.sphereFunctions[outdated[0]], mainPool, globalDescriptorSet, frameIndex, extent, sphereFunctions[outdated[0]]);
+		}
+		else if (outdated.size() > 1) {
+			VVT_PROFILE_SCOPE("Parallel sphere function recording");
+
+			// Every job writes its own CachedCommands and records from the pool of the worker it runs on
+			std::vector<std::future<void>> jobs;
+			jobs.reserve(outdated.size());
+			for (size_t index : outdated) {
+				jobs.push_back(threadPool.submit([this, &frame, &sphereFunctions, index, globalDescriptorSet, frameIndex, extent]() {
+					uint32_t poolIndex = static_cast<uint32_t>(threadPool.getCurrentWorkerIndex());
+					recordSphereFunction(frame.sphereFunctions[index], poolIndex, globalDescriptorSet, frameIndex, extent, sphereFunctions[index]);
+				}));
+			}
+
+			// All jobs have to finish before an exception may leave this function, they reference its locals
+			for (auto& job : jobs) {
+				job.wait();
+			}
+			for (auto& job : jobs) {
+				job.get();
+			}
+		}
+
+		for (const auto& cached : retired) {
+			if (cached.commandBuffer != VK_NULL_HANDLE) {
+				recordingPools[cached.pool].freeCommandBuffers.push_back(cached.commandBuffer);
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -2,11 +2,19 @@
 
 #include "vvt_camera.hpp"
 #include "vvt_pipeline.hpp"
+#include "vvt_pipeline_registry.hpp"
+#include "vvt_shader_manager.hpp"
 #include "vvt_device.hpp"
 #include "vvt_game_object.hpp"
 #include "sphere_container.hpp"
+#include "vvt_gpu_profiler.hpp"
+#include "vvt_model.hpp"
+#include "vvt_thread_pool.hpp"
+#include "enums.hpp"
 
 // std 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -17,28 +25,160 @@ namespace vvt {
 		glm::vec3 color{ 1.f };
 	};
 
+	struct PointPushConstant {
+		glm::mat4 modelMatrix{ 1.f };
+		float colorScale{ 1.f };
+		float pointScale{ 0.03f };
+	};
+
 	class SimpleRenderSystem
 	{
 	public:
+		// How the spherical functions are shaded, compiled into the point, surface and reconstruction pipelines as specialization constants
+		struct PointStyle {
+			int reconstructionOrder = BASIS_FUNCTION_MAX_ORDER;	// Highest SH band the reconstruction sums up
+			ColorMode colorMode = SIGNED_RED_BLUE;
+			bool lighting = true;
+		};
 
-		SimpleRenderSystem(VvtDevice& device, VkRenderPass sceneRenderPass, VkRenderPass skyboxRenderPass, VkDescriptorSetLayout globalSetLayout);
+
+		// The point and reconstruction pipelines read the vertices of point models with the given layout
+		SimpleRenderSystem(VvtDevice& device, VvtThreadPool& threadPool, VkRenderPass sceneRenderPass, VkRenderPass skyboxRenderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout shCoefficientSetLayout, VvtModel::VertexLayout pointModelLayout);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
-		void renderGameObjects(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet,
+		/*
+		* Executes the scene draws inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+		* Every frame in flight has its own secondary command buffers: one for the game objects and one per spherical
+		* function. They are reused until what they were recorded with changes (see SphereContainer::getRevision and
+		* invalidateSceneCommands), outdated spherical functions are re-recorded in parallel on the thread pool.
+		* renderPass is the render pass the commands run in, the swap chain creates a new one when it is recreated.
+		*/
+		void renderGameObjects(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent,
 								std::vector<VvtGameObject> &gameObjects, std::vector<SphereContainer> &sphereFunctions, 
-								const VvtCamera& camera, const float frameDeltaTime, VvtGameObject* viewerObj);
+								const VvtCamera& camera, const float frameDeltaTime, VvtGameObject* viewerObj, VvtGpuProfiler& gpuProfiler);
+
+		// For changes the revisions don't cover, e.g. moving game objects
+		void invalidateSceneCommands();
+		// Pipelines of a new style are created the next time the spherical functions are recorded
+		void setPointStyle(const PointStyle& style);
+		const PointStyle& getPointStyle() const { return pointStyle; }
+		uint32_t getPipelineVariantCount() const { return pointPipelines.getVariantCount() + reconstructionPipelines.getVariantCount(); }
+		// Secondary command buffers recorded so far, for the UI
+		uint32_t getSceneRecordCount() const { return sceneRecordCount; }
+
+		// Registers the GLSL sources of all SPIR-V files the pipelines are created from
+		void watchShaders(VvtShaderManager& shaderManager) const;
+		/*
+		* Recreates all pipelines from the current shader code, call between frames. Pipelines that fail to be created
+		* keep the previous one. Replaced pipelines are destroyed once no frame in flight can use them anymore.
+		* renderPass is the current render pass of the swap chain, like for renderGameObjects.
+		*/
+		void reloadPipelines(VkRenderPass renderPass);
 
 	private:
+		// Shader side of PointStyle and the visualization mode, constant_id i is the i-th member
+		struct PointSpecialization {
+			int32_t shOrder;
+			int32_t colorMode;
+			VkBool32 lighting;
+			VkBool32 displace;
+		};
+
+		struct RetiredPipeline {
+			std::unique_ptr<VvtPipeline> pipeline;
+			uint64_t retiredAtFrame = 0;
+		};
+
+		struct CachedCommands {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			uint32_t pool = 0;	// Index into recordingPools
+			bool recorded = false;
+			const void* source = nullptr;
+			uint64_t revision = 0;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkExtent2D extent{};
+			VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
+
+			bool isUpToDate(const void* source, uint64_t revision, VkRenderPass renderPass, VkExtent2D extent, VkDescriptorSet globalDescriptorSet) const;
+		};
+
+		struct FrameCommands {
+			// Game objects, also begins the GPU scope of the spherical functions which sceneEnd ends
+			CachedCommands scene;
+			VkCommandBuffer sceneEnd = VK_NULL_HANDLE;
+			VvtGpuProfiler::ScopeCapture profilerScopes;
+			std::vector<CachedCommands> sphereFunctions;
+		};
+
+		// Command pools are externally synchronized, so every worker records from its own, the last one is the main thread's
+		struct RecordingPool {
+			VkCommandPool pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> freeCommandBuffers;
+		};
+
+		void createRecordingPools();
+		void createFrameCommands();
+		// Only the thread owning the pool may call this while recording in parallel
+		VkCommandBuffer acquireCommandBuffer(uint32_t poolIndex);
+		void beginSecondary(VkCommandBuffer commandBuffer, VkExtent2D extent);
+		void endSecondary(VkCommandBuffer commandBuffer);
+
+		void recordGameObjects(VkCommandBuffer commandBuffer, VkDescriptorSet globalDescriptorSet, std::vector<VvtGameObject>& gameObjects);
+		// Revision of the recorded commands of a spherical function, which also depend on the point style and pipelines
+		uint64_t getSphereFunctionRevision(const SphereContainer& sphereFunction) const;
+		void recordSphereFunction(CachedCommands& cached, uint32_t poolIndex, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent, SphereContainer& sphereFunction);
+		void recordSphereFunctions(FrameCommands& frame, VkDescriptorSet globalDescriptorSet, int frameIndex, VkExtent2D extent, std::vector<SphereContainer>& sphereFunctions);
+
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
+		void createPointPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+		void createReconstructionPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout shCoefficientSetLayout);
+		// Function or reconstruction pipeline of a style, drawing point glyphs or a surface depending on the mode
+		std::unique_ptr<VvtPipeline> createPointStylePipeline(const PointStyle& style, VisualizationMode mode, bool reconstruction, VkRenderPass renderPass);
+		static uint64_t getPointStyleKey(const PointStyle& style, VisualizationMode mode);
+		// Vertex input of the point model followed by the per-instance streams
+		void pointPipelineConfigInfo(PipelineConfigInfo& configInfo) const;
+		// The same streams read per vertex, the triangles are indexed by a SphereMesh
+		static void surfacePipelineConfigInfo(PipelineConfigInfo& configInfo);
+		std::string getPointVertexShaderPath(const std::string& shaderName) const;
+		// Variants of the current point style, created on first use against the render pass of the frame being recorded
+		VvtPipeline& getPointPipeline(VisualizationMode mode);
+		VvtPipeline& getReconstructionPipeline(VisualizationMode mode);
 
 		VvtDevice& vvtDevice;
+		VvtThreadPool& threadPool;
+		VvtModel::VertexLayout pointModelLayout;
+		// Render pass of the frame being recorded, set by renderGameObjects before any secondary command buffer begins
+		VkRenderPass recordingRenderPass = VK_NULL_HANDLE;
+
+		std::vector<RecordingPool> recordingPools;
+		std::vector<FrameCommands> frameCommands;
+		uint64_t invalidations = 0;
+		std::atomic<uint32_t> sceneRecordCount{ 0 };
 
 		float clock;
 		std::unique_ptr<VvtPipeline> vvtPipeline;
 		VkPipelineLayout pipelineLayout;
+
+		// Instanced point clouds or surfaces of the spherical functions, one variant per point style and mode
+		VvtPipelineRegistry pointPipelines;
+		VkPipelineLayout pointPipelineLayout;
+
+		// SH reconstructions, evaluated in the vertex shader from a coefficient UBO (set 1)
+		VvtPipelineRegistry reconstructionPipelines;
+		VkPipelineLayout reconstructionPipelineLayout;
+
+		PointStyle pointStyle{};
+		uint64_t pipelineRevision = 0;	// Changes with the point style and when the pipelines are reloaded
+		// Variants of the point style used by the current recording per visualization mode, resolved on the main thread before it starts
+		std::array<VvtPipeline*, 3> activePointPipelines{};
+		std::array<VvtPipeline*, 3> activeReconstructionPipelines{};
+
+		// Pipelines replaced by reloadPipelines, secondary command buffers of frames in flight may still reference them
+		std::vector<RetiredPipeline> retiredPipelines;
+		uint64_t frameCount = 0;
 	};
 }
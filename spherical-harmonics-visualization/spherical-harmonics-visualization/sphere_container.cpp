@@ -1,109 +1,179 @@
 #include "sphere_container.hpp"
 #include "simple_render_system.hpp"
+#include "vvt_profiler.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 namespace vvt {
-	SphereContainer::SphereContainer(glm::vec3 pos, glm::vec3 rot, float radius, sh::SphericalFunction sphFunc, std::shared_ptr<VvtModel> model): radius{radius}, 																																		  sphFunc{sphFunc}, pointModel{model}
+	SphereContainer::SphereContainer(VvtDevice& device, VvtThreadPool& threadPool, ShCoefficientCache& coefficientCache, glm::vec3 pos, glm::vec3 rot, float radius, sh::SphericalFunction sphFunc, std::string functionId, std::shared_ptr<VvtModel> model): vvtDevice{device}, threadPool{threadPool}, coefficientCache{coefficientCache}, radius{radius}, 																																		  sphFunc{sphFunc}, functionId{functionId}, pointModel{model}
 	{
 		transform.translation = pos;
 		transform.rotation = rot;
 		transform.scale = { 1.0f, 1.0f, 1.0f };
 		decomposeToBasisFunctions(BASIS_FUNCTION_MAX_ORDER, MONTE_CARLO_SAMPLE_AMOUNT);
 		visualizeBasisFunctions();
-		generateReconstruction();
 	}
 
 	void SphereContainer::generateSpherePoints()
 	{
-		for (int i = 0; i < resolution; i++)
+		VVT_PROFILE_FUNCTION();
+		ShDirections directions = ShDirections::sample(getSampledScheme(), pointCount);
+		surfaceMesh = visualizationMode == POINT_CLOUD ? nullptr : SphereMesh::get(vvtDevice, pointCount);
+		points = PointField{ directions.size() };
+		for (size_t i = 0; i < directions.size(); i++)
 		{
-			for (int j = 0; j < resolution; j++)
-			{
-				float phi = (static_cast<float>(i) / static_cast<float>(resolution)) * 2 * glm::pi<float>();
-				float theta = (static_cast<float>(j) / static_cast<float>(resolution)) * glm::pi<float>();
+			glm::vec3 direction{ directions.x[i], directions.y[i], directions.z[i] };
+			setSphere3DPoint(i, direction, directions.getPhi(i), directions.getTheta(i));
+		}
 
-				addSphere3DPoint(phi, theta);
-			}
+		// The point field already has the layout of the instance streams. Resampling waits for the device first,
+		// so the previous buffers are overwritten whenever the new points fit
+		points.updatePositionBuffer(vvtDevice, pointPositionBuffer);
+		points.updateValueBuffer(vvtDevice, pointValueBuffer);
+		revision++;
+	}
+
+	/* One uniform buffer per frame in flight, so updating the coefficients never touches a buffer the GPU is reading */
+	void SphereContainer::initCoefficientBuffers(VvtDescriptorSetLayout& setLayout, VvtDescriptorPool& pool)
+	{
+		coefficientBuffers.resize(VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
+		coefficientDescriptorSets.resize(VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (int i = 0; i < coefficientBuffers.size(); i++)
+		{
+			coefficientBuffers[i] = std::make_unique<VvtBuffer>(
+				vvtDevice,
+				sizeof(ShCoefficientUbo),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			coefficientBuffers[i]->map();
+
+			auto bufferInfo = coefficientBuffers[i]->descriptorInfo();
+			VvtDescriptorWriter(setLayout, pool)
+				.writeBuffer(0, &bufferInfo)
+				.build(coefficientDescriptorSets[i]);
 		}
+		dirtyCoefficientFrames = VvtSwapChain::MAX_FRAMES_IN_FLIGHT;
+		revision++;
 	}
 
+	/*
+	* The sample cloud is rotated rigidly by its model matrix. The reconstruction is rotated in SH space instead,
+	* by applying the band rotation matrices to the coefficients, so the reconstructed function itself rotates.
+	*/
 	void SphereContainer::updateRotation()
 	{
-		glm::mat4 rotMatrix = transform.mat4();
+		updateCoefficients();
+	}
+
+	void SphereContainer::updateCoefficients()
+	{
+		rotateCoefficients();
 
-		for (int i = 0; i < points.size(); i++)
+		for (auto& b : basisFunctions)
 		{
-			// Rotate original sphere function and reconstructed sphere function
-			glm::vec4 rotatedPoint = rotMatrix * glm::vec4{ ogPointPositions[i], 1.0f};
-			points[i].first = {rotatedPoint.x, rotatedPoint.y, rotatedPoint.z};
-			pointsReconstructed[i].first = glm::vec3{ rotatedPoint.x, rotatedPoint.y, rotatedPoint.z } + glm::vec3{ -(2 * radius + 1.0f), 0.0f, 0.0f };
+			b.setCoefficient(rotatedCoeffs[sh::GetIndex(b.getOrder(), b.getDegree())]);
 		}
-	}
 
+		// The reconstruction is evaluated in the vertex shader, every frame in flight needs the new coefficients
+		dirtyCoefficientFrames = VvtSwapChain::MAX_FRAMES_IN_FLIGHT;
 
-	void SphereContainer::render(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout)
+		// The model matrix of the point cloud and the basis function colors are part of the draw commands
+		revision++;
+	}
+
+	void SphereContainer::rotateCoefficients()
 	{
-		// Draw spherical function
-		for (auto& p : points)
-		{
-			TransformComponent pointTransform;
-			pointTransform.translation = p.first;
-			pointTransform.scale = { 0.03f, 0.03f, 0.03f };
-	
-			TestPushConstant push{};
-			push.modelMatrix = pointTransform.mat4();
-			push.normalMatrix = pointTransform.normalMatrix();
-			if (p.second < 0.0f)
+		glm::mat3 rotation{ transform.mat4() };
+
+		double rotationMatrix[3][3];
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 3; column++)
 			{
-				push.color = { 0.0f, 0.0f, 1.0f * abs(p.second) };
-			}
-			else {
-				push.color = { 1.0f * abs(p.second), 0.0f, 0.0f };
+				rotationMatrix[row][column] = rotation[column][row];
 			}
+		}
 
-			vkCmdPushConstants(
-				commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(TestPushConstant),
-				&push);
+		ShRotation shRotation{ BASIS_FUNCTION_MAX_ORDER, rotationMatrix };
+		shRotation.apply(basisCoeffs, rotatedCoeffs);
+	}
 
-			pointModel->bind(commandBuffer);
-			pointModel->draw(commandBuffer);
+	void SphereContainer::setProjectionMethod(ProjectionMethod method)
+	{
+		if (method == projectionMethod)
+		{
+			return;
 		}
+		projectionMethod = method;
 
-		// Draw reconstructed spherical function
-		for (auto& p : pointsReconstructed)
+		// Instance buffers of the basis functions might still be in use
+		vkDeviceWaitIdle(vvtDevice.device());
+
+		basisFunctions.clear();
+		decomposeToBasisFunctions(BASIS_FUNCTION_MAX_ORDER, MONTE_CARLO_SAMPLE_AMOUNT);
+		visualizeBasisFunctions();
+		dirtyCoefficientFrames = VvtSwapChain::MAX_FRAMES_IN_FLIGHT;
+		revision++;
+	}
+
+	void SphereContainer::setSampling(SamplingScheme scheme, uint32_t pointCount)
+	{
+		if (scheme == samplingScheme && pointCount == this->pointCount)
 		{
-			TransformComponent pointTransform;
-			pointTransform.translation = p.first;
-			pointTransform.scale = { 0.03f, 0.03f, 0.03f };
+			return;
+		}
+		samplingScheme = scheme;
+		this->pointCount = pointCount;
 
-			TestPushConstant push{};
-			push.modelMatrix = pointTransform.mat4();
-			push.normalMatrix = pointTransform.normalMatrix();
-			if (p.second < 0.0f)
-			{
-				push.color = { 0.0f, 0.0f, 1.0f * abs(p.second) };
-			}
-			else {
-				push.color = { 1.0f * abs(p.second), 0.0f, 0.0f };
-			}
+		// Instance buffers of the points and basis functions might still be in use
+		vkDeviceWaitIdle(vvtDevice.device());
 
-			vkCmdPushConstants(
-				commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(TestPushConstant),
-				&push);
+		generateSpherePoints();
+		basisFunctions.clear();
+		visualizeBasisFunctions();
+	}
 
+	void SphereContainer::setVisualizationMode(VisualizationMode mode)
+	{
+		if (mode == visualizationMode)
+		{
+			return;
+		}
+		bool resample = (mode == POINT_CLOUD) != (visualizationMode == POINT_CLOUD);
+		visualizationMode = mode;
+
+		// Both surface modes draw the same samples and only differ in their pipelines
+		if (resample)
+		{
+			vkDeviceWaitIdle(vvtDevice.device());
+			generateSpherePoints();
+			basisFunctions.clear();
+			visualizeBasisFunctions();
+		}
+		revision++;
+	}
+
+	void SphereContainer::render(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout)
+	{
+		if (!surfaceMesh)
+		{
 			pointModel->bind(commandBuffer);
-			pointModel->draw(commandBuffer);
 		}
 
-		// Draw basis functions
-		double maxCoeff = *std::max_element(basisCoeffs.begin(), basisCoeffs.end());;
+		// Draw spherical function
+		drawPoints(commandBuffer, pipelineLayout, static_cast<uint32_t>(points.size()), transform.mat4());
+
+		// Draw basis functions, rotating flips the signs of coefficients, so they are scaled by the largest magnitude
+		double maxCoeff = 0.0;
+		for (double coeff : rotatedCoeffs)
+		{
+			maxCoeff = std::max(maxCoeff, std::abs(coeff));
+		}
+		if (maxCoeff == 0.0)
+		{
+			maxCoeff = 1.0;
+		}
 		for (auto& b : basisFunctions)
 		{
 			b.render(commandBuffer, pipelineLayout, pointModel, maxCoeff);
@@ -111,74 +181,122 @@ namespace vvt {
 
 	}
 
+	/* Kept out of renderReconstruction, since the recorded draw commands are reused while the coefficients change */
+	void SphereContainer::updateCoefficientBuffer(int frameIndex)
+	{
+		if (dirtyCoefficientFrames > 0)
+		{
+			ShCoefficientUbo ubo{};
+			for (size_t k = 0; k < rotatedCoeffs.size(); k++)
+			{
+				ubo.coeffs[k / 4][k % 4] = static_cast<float>(rotatedCoeffs[k]);
+			}
+			coefficientBuffers[frameIndex]->writeToBuffer(&ubo);
+			dirtyCoefficientFrames--;
+		}
+	}
 
-	void SphereContainer::addSphere3DPoint(double phi, double theta)
+	/* Expects the reconstruction pipeline to be bound, the SH sum is evaluated per instance in the vertex shader */
+	void SphereContainer::renderReconstruction(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, int frameIndex)
 	{
-		Eigen::Vector3d dirVectorFromSphericalCoords = sh::ToVector(phi, theta);
-		glm::vec3 glmDirVector = { dirVectorFromSphericalCoords.x(), dirVectorFromSphericalCoords.y(), dirVectorFromSphericalCoords.z() };
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			1, 1,
+			&coefficientDescriptorSets[frameIndex], 0,
+			nullptr);
 
-		glm::vec3 pointPos = transform.translation + glm::normalize(glmDirVector) * radius;
-		double pointValue = sphFunc(phi, theta); 
+		if (!surfaceMesh)
+		{
+			pointModel->bind(commandBuffer);
+		}
 
-		points.push_back(std::make_pair(pointPos, pointValue));
-		ogPointPositions.push_back(pointPos);
+		// Same sample positions as the spherical function, translated to the left of it
+		glm::mat4 reconstructionMatrix = glm::translate(glm::mat4{ 1.0f }, transform.translation + glm::vec3{ -(2 * radius + 1.0f), 0.0f, 0.0f });
+		drawPoints(commandBuffer, pipelineLayout, static_cast<uint32_t>(points.size()), reconstructionMatrix);
 	}
 
-	void SphereContainer::addSphere3DPointReconstructed(double phi, double theta)
+	void SphereContainer::drawPoints(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, uint32_t instanceCount, const glm::mat4& modelMatrix)
 	{
-		Eigen::Vector3d dirVectorFromSphericalCoords = sh::ToVector(phi, theta);
-		glm::vec3 glmDirVector = { dirVectorFromSphericalCoords.x(), dirVectorFromSphericalCoords.y(), dirVectorFromSphericalCoords.z() };
+		// Point positions are relative to the center of the sphere
+		PointPushConstant push{};
+		push.modelMatrix = modelMatrix;
+		push.colorScale = 1.0f;
 
-		// Translated to the left of the original spherical function
-		glm::vec3 pointPos = transform.translation + glm::vec3{-(2 * radius + 1.0f), 0.0f, 0.0f} + glm::normalize(glmDirVector) * radius;
-		double pointValue = sh::EvalSHSum(BASIS_FUNCTION_MAX_ORDER, basisCoeffs, phi, theta);
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			sizeof(PointPushConstant),
+			&push);
 
-		pointsReconstructed.push_back(std::make_pair(pointPos, pointValue));
+		PointInstance::bind(commandBuffer, pointPositionBuffer->getBuffer(), 0, pointValueBuffer->getBuffer(), 0);
+
+		if (surfaceMesh)
+		{
+			surfaceMesh->draw(commandBuffer);
+		}
+		else
+		{
+			pointModel->draw(commandBuffer, instanceCount);
+		}
 	}
 
+	void SphereContainer::setSphere3DPoint(size_t index, const glm::vec3& direction, double phi, double theta)
+	{
+		glm::vec3 pointPos = glm::normalize(direction) * radius;
+		double pointValue = sphFunc(phi, theta); 
+
+		points.setPoint(index, pointPos, static_cast<float>(pointValue));
+	}
 
 	void SphereContainer::decomposeToBasisFunctions(int order, int samples)
 	{
-		std::unique_ptr<std::vector<double>> coeffs = sh::ProjectFunction(order, sphFunc, samples);
-		basisCoeffs = *coeffs;
+		VVT_PROFILE_FUNCTION();
+		ShCoefficientCacheKey cacheKey{ functionId, order, projectionMethod, static_cast<uint64_t>(samples), MONTE_CARLO_SEED };
+
+		// Warm starts read the coefficients from the cache and skip the projection entirely
+		if (functionId.empty() || !coefficientCache.load(cacheKey, projection))
+		{
+			ShProjector projector{ threadPool };
+			projection = projector.project(projectionMethod, sphFunc, order, samples, MONTE_CARLO_SEED);
+			if (!functionId.empty() && !coefficientCache.store(cacheKey, projection))
+			{
+				std::cerr << "Failed to write the coefficient cache file " << coefficientCache.getFilepath(cacheKey) << std::endl;
+			}
+		}
+		basisCoeffs = projection.coeffs;
+		rotateCoefficients();
 	}
 
 	void SphereContainer::visualizeBasisFunctions()
 	{
-		int index = 0;
+		VVT_PROFILE_FUNCTION();
+		// All basis functions are evaluated once per grid and shared between every sphere, each BasisContainer reads its own column
+		std::shared_ptr<ShBasisTable> table = ShBasisTable::get(vvtDevice, getSampledScheme(), getBasisPointCount(), BASIS_FUNCTION_MAX_ORDER);
+		std::shared_ptr<SphereMesh> basisMesh = visualizationMode == POINT_CLOUD ? nullptr : SphereMesh::get(vvtDevice, getBasisPointCount());
+
 		for (int i = 0; i <= BASIS_FUNCTION_MAX_ORDER; i++)
 		{
 			for (int j = 0; j <= i; j++)
 			{
 				if (j == 0) {
-					BasisContainer basis0 = {basisCoeffs[index], i, 0, radius, transform.translation + glm::vec3{(2 * radius + 1.0f) * (i + 1), 0.0f, 0.0f}, transform.rotation };
-					basisFunctions.push_back(basis0);
-					index++;
+					int index = sh::GetIndex(i, 0);
+					BasisContainer basis0 = {table, basisMesh, rotatedCoeffs[index], i, 0, radius, transform.translation + glm::vec3{(2 * radius + 1.0f) * (i + 1), 0.0f, 0.0f} };
+					basisFunctions.push_back(std::move(basis0));
 				}
 				else {
-					BasisContainer basis_j_pos = { basisCoeffs[index], i, -j, radius, transform.translation + glm::vec3{(2 * radius + 1.0f)* (i + 1), j * -(2 * radius + 1.0f), 0.0f}, transform.rotation };
-					basisFunctions.push_back(basis_j_pos);
-					index++;
+					int index = sh::GetIndex(i, -j);
+					BasisContainer basis_j_pos = { table, basisMesh, rotatedCoeffs[index], i, -j, radius, transform.translation + glm::vec3{(2 * radius + 1.0f)* (i + 1), j * -(2 * radius + 1.0f), 0.0f} };
+					basisFunctions.push_back(std::move(basis_j_pos));
 
-					BasisContainer basis_j_neg = { basisCoeffs[index], i, j, radius, transform.translation + glm::vec3{(2 * radius + 1.0f)* (i + 1), j * (2 * radius + 1.0f), 0.0f}, transform.rotation };
-					basisFunctions.push_back(basis_j_neg);
-					index++;
+					index = sh::GetIndex(i, j);
+					BasisContainer basis_j_neg = { table, basisMesh, rotatedCoeffs[index], i, j, radius, transform.translation + glm::vec3{(2 * radius + 1.0f)* (i + 1), j * (2 * radius + 1.0f), 0.0f} };
+					basisFunctions.push_back(std::move(basis_j_neg));
 				}
 			}
 		}
 	}
-
-	void SphereContainer::generateReconstruction()
-	{
-		for (int i = 0; i < resolution; i++)
-		{
-			for (int j = 0; j < resolution; j++)
-			{
-				float phi = (static_cast<float>(i) / static_cast<float>(resolution)) * 2 * glm::pi<float>();
-				float theta = (static_cast<float>(j) / static_cast<float>(resolution)) * glm::pi<float>();
-
-				addSphere3DPointReconstructed(phi, theta);
-			}
-		}
-	}
 }
\ No newline at end of file
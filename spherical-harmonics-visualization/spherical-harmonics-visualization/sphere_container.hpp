@@ -1,47 +1,115 @@
 #pragma once
 #include "vvt_model.hpp"
+#include "vvt_buffer.hpp"
+#include "vvt_descriptors.hpp"
+#include "vvt_swap_chain.hpp"
 #include "vvt_game_object.hpp"
 #include "basis_container.hpp"
+#include "point_field.hpp"
+#include "point_instance.hpp"
+#include "sh_basis_table.hpp"
+#include "sphere_mesh.hpp"
+#include "sh_projection.hpp"
+#include "sh_rotation.hpp"
+#include "sh_coefficient_cache.hpp"
+#include "vvt_thread_pool.hpp"
+#include "enums.hpp"
 
 #include <spherical_harmonics.h>
 #include <memory>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
 #define MONTE_CARLO_SAMPLE_AMOUNT 10000
+#define MONTE_CARLO_SEED 1337
 #define BASIS_FUNCTION_MAX_ORDER 3
+#define BASIS_POINT_FRACTION 0.64f
 
 namespace vvt {
 
+	static_assert((BASIS_FUNCTION_MAX_ORDER + 1) * (BASIS_FUNCTION_MAX_ORDER + 1) <= 16, "The reconstruction shader evaluates at most 16 coefficients!");
+
+	// Coefficients of the reconstruction as read by sh_reconstruction_shader.vert (std140)
+	struct ShCoefficientUbo {
+		glm::vec4 coeffs[4]{};
+	};
+
 	class SphereContainer {
 	public:
-		SphereContainer(glm::vec3 pos, glm::vec3 rot, float radius, sh::SphericalFunction sphFunc, std::shared_ptr<VvtModel> model);
+		// An empty functionId disables the coefficient cache for this function
+		SphereContainer(VvtDevice& device, VvtThreadPool& threadPool, ShCoefficientCache& coefficientCache, glm::vec3 pos, glm::vec3 rot, float radius, sh::SphericalFunction sphFunc, std::string functionId, std::shared_ptr<VvtModel> model);
 
 		glm::vec3& getRotation() { return transform.rotation; };
+		std::vector<double>& getCoefficients() { return basisCoeffs; }
+		ProjectionMethod getProjectionMethod() const { return projectionMethod; }
+		const ShProjection& getProjection() const { return projection; }
+		// Changes whenever recorded draw commands of this function become outdated
+		uint64_t getRevision() const { return revision; }
+
+		// Re-projects the spherical function and rebuilds the basis functions and reconstruction
+		void setProjectionMethod(ProjectionMethod method);
+
+		SamplingScheme getSamplingScheme() const { return samplingScheme; }
+		// Target amount of points of the function, the basis functions are drawn with BASIS_POINT_FRACTION of it
+		uint32_t getPointCount() const { return pointCount; }
+		// The selected scheme for point clouds, the icosphere the surface mesh is built on otherwise
+		SamplingScheme getSampledScheme() const { return visualizationMode == POINT_CLOUD ? samplingScheme : ICOSPHERE; }
+		// Regenerates the points of the function, its reconstruction and its basis functions
+		void setSampling(SamplingScheme scheme, uint32_t pointCount);
+
+		VisualizationMode getVisualizationMode() const { return visualizationMode; }
+		/*
+		* Surfaces are drawn as one icosphere mesh each, with ICOSPHERE samples of about the same count as vertices
+		* instead of a point model per sample. Regenerates the points and basis functions like setSampling.
+		*/
+		void setVisualizationMode(VisualizationMode mode);
 
 		void generateSpherePoints();
+		void initCoefficientBuffers(VvtDescriptorSetLayout& setLayout, VvtDescriptorPool& pool);
 		void updateRotation();
+		// Call after the (unrotated) coefficients were edited
+		void updateCoefficients();
+		// Writes pending coefficient changes to the UBO of the frame, has to be called every frame before rendering
+		void updateCoefficientBuffer(int frameIndex);
 		void render(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout);
+		void renderReconstruction(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, int frameIndex);
 
 	private:
-		void addSphere3DPoint(double phi, double theta);
-		void addSphere3DPointReconstructed(double phi, double theta);
+		void setSphere3DPoint(size_t index, const glm::vec3& direction, double phi, double theta);
 		void decomposeToBasisFunctions(int order, int samples);
 		void visualizeBasisFunctions();
-		void generateReconstruction();
-		
+		void rotateCoefficients();
+		void drawPoints(VkCommandBuffer& commandBuffer, VkPipelineLayout& pipelineLayout, uint32_t instanceCount, const glm::mat4& modelMatrix);
+		uint32_t getBasisPointCount() const { return static_cast<uint32_t>(static_cast<float>(pointCount) * BASIS_POINT_FRACTION); }
+
+		VvtDevice& vvtDevice;
+		VvtThreadPool& threadPool;
+		ShCoefficientCache& coefficientCache;
 		float radius;
 		sh::SphericalFunction sphFunc;
+		std::string functionId;
 		std::shared_ptr<VvtModel> pointModel;
+		std::shared_ptr<SphereMesh> surfaceMesh;	// Only set for surface visualizations
 		TransformComponent transform;
-		std::vector<std::pair<glm::vec3, double>> points;		
-		std::vector<std::pair<glm::vec3, double>> pointsReconstructed;
+		PointField points;
+		std::unique_ptr<VvtBuffer> pointPositionBuffer;
+		std::unique_ptr<VvtBuffer> pointValueBuffer;
+		std::vector<std::unique_ptr<VvtBuffer>> coefficientBuffers;
+		std::vector<VkDescriptorSet> coefficientDescriptorSets;
+		int dirtyCoefficientFrames = 0;
+		uint64_t revision = 0;
 
-		std::vector<glm::vec3> ogPointPositions;
 		std::vector<double> basisCoeffs;
+		std::vector<double> rotatedCoeffs;	// basisCoeffs rotated by the current transform
+		ProjectionMethod projectionMethod = GAUSS_LEGENDRE;
+		ShProjection projection;
 		std::vector<BasisContainer> basisFunctions;
 
-		int resolution = 100;
+		// 6000 equal-area points are about as dense as a 100 x 100 (phi, theta) grid at its equator
+		SamplingScheme samplingScheme = FIBONACCI_LATTICE;
+		uint32_t pointCount = 6000;
+		VisualizationMode visualizationMode = POINT_CLOUD;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "sphere_mesh.hpp"
+
+// std
+#include <cassert>
+#include <vector>
+
+namespace vvt {
+
+	std::mutex SphereMesh::cacheMutex;
+	std::map<int, std::weak_ptr<SphereMesh>> SphereMesh::cache;
+
+	std::shared_ptr<SphereMesh> SphereMesh::get(VvtDevice& device, uint32_t targetCount)
+	{
+		int subdivisions = ShDirections::getIcosphereSubdivisions(targetCount);
+		std::lock_guard<std::mutex> lock{ cacheMutex };
+
+		if (auto mesh = cache[subdivisions].lock())
+		{
+			assert(&mesh->vvtDevice == &device && "Sphere meshes are shared process-wide and have to be used with a single device!");
+			return mesh;
+		}
+
+		auto mesh = std::make_shared<SphereMesh>(device, subdivisions);
+		cache[subdivisions] = mesh;
+		return mesh;
+	}
+
+	SphereMesh::SphereMesh(VvtDevice& device, int subdivisions) : vvtDevice{ device }, subdivisions{ subdivisions }
+	{
+		std::vector<uint32_t> indices;
+		ShDirections::icosphere(subdivisions, &indices);
+		indexCount = static_cast<uint32_t>(indices.size());
+
+		indexBuffer = std::make_unique<VvtBuffer>(
+			vvtDevice,
+			sizeof(uint32_t),
+			indexCount,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		vvtDevice.getUploadManager().uploadBuffer(
+			indexBuffer->getBuffer(), indices.data(), sizeof(uint32_t) * indices.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+	}
+
+	void SphereMesh::draw(VkCommandBuffer commandBuffer) const
+	{
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "vvt_device.hpp"
+#include "vvt_buffer.hpp"
+#include "sh_evaluator.hpp"
+
+// std
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace vvt {
+
+	/*
+	* Triangles of an icosphere as an index buffer. The vertices are the directions of ShDirections::icosphere with the
+	* same subdivisions, i.e. the ICOSPHERE samples of a point field or basis table, so their position and value
+	* streams (PointInstance bindings, read per vertex) are drawn as one continuous surface with a single indexed draw.
+	* Meshes are shared process-wide per subdivision level.
+	*/
+	class SphereMesh
+	{
+	public:
+		// Mesh over ShDirections::sample(ICOSPHERE, targetCount)
+		static std::shared_ptr<SphereMesh> get(VvtDevice& device, uint32_t targetCount);
+
+		SphereMesh(VvtDevice& device, int subdivisions);
+
+		SphereMesh(const SphereMesh&) = delete;
+		SphereMesh& operator=(const SphereMesh&) = delete;
+
+		int getSubdivisions() const { return subdivisions; }
+		uint32_t getIndexCount() const { return indexCount; }
+
+		// Expects the position and value streams to be bound
+		void draw(VkCommandBuffer commandBuffer) const;
+
+	private:
+		VvtDevice& vvtDevice;
+		int subdivisions;
+		uint32_t indexCount = 0;
+		std::unique_ptr<VvtBuffer> indexBuffer;
+
+		static std::mutex cacheMutex;
+		static std::map<int, std::weak_ptr<SphereMesh>> cache;
+	};
+}
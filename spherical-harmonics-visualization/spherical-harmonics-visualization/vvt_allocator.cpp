@@ -0,0 +1,299 @@
+#include "vvt_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace vvt {
+
+namespace {
+
+VkDeviceSize nextPowerOfTwo(VkDeviceSize value) {
+  VkDeviceSize power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+VkDeviceSize previousPowerOfTwo(VkDeviceSize value) {
+  VkDeviceSize power = 1;
+  while (power <= value / 2) {
+    power <<= 1;
+  }
+  return power;
+}
+
+}  // namespace
+
+VvtAllocator::BuddyBlock::BuddyBlock(VkDeviceSize size, VkDeviceSize minNodeSize)
+    : size{size}, freeBytes{size} {
+  assert(size >= minNodeSize && (size & (size - 1)) == 0 && "Buddy blocks need a power of two size!");
+  freeLists.resize(getLevel(minNodeSize) + 1);
+  freeLists[0].insert(0);
+}
+
+uint32_t VvtAllocator::BuddyBlock::getLevel(VkDeviceSize nodeSize) const {
+  uint32_t level = 0;
+  while ((size >> level) > nodeSize) {
+    level++;
+  }
+  return level;
+}
+
+bool VvtAllocator::BuddyBlock::allocate(VkDeviceSize nodeSize, VkDeviceSize &offset) {
+  if (nodeSize > size) {
+    return false;
+  }
+  uint32_t level = getLevel(nodeSize);
+  assert(level < freeLists.size() && "Node size below the minimum allocation size!");
+
+  // Smallest free node that fits, split down to the requested level
+  int freeLevel = static_cast<int>(level);
+  while (freeLevel >= 0 && freeLists[freeLevel].empty()) {
+    freeLevel--;
+  }
+  if (freeLevel < 0) {
+    return false;
+  }
+
+  // Lowest offset first keeps the allocations packed at the start of the block
+  offset = *freeLists[freeLevel].begin();
+  freeLists[freeLevel].erase(freeLists[freeLevel].begin());
+  for (uint32_t splitLevel = freeLevel + 1; splitLevel <= level; splitLevel++) {
+    freeLists[splitLevel].insert(offset + (size >> splitLevel));
+  }
+
+  freeBytes -= nodeSize;
+  return true;
+}
+
+void VvtAllocator::BuddyBlock::free(VkDeviceSize offset, VkDeviceSize nodeSize) {
+  uint32_t level = getLevel(nodeSize);
+  freeBytes += nodeSize;
+
+  // Merge with the buddy as long as it is free as well
+  while (level > 0) {
+    VkDeviceSize buddy = offset ^ (size >> level);
+    auto it = freeLists[level].find(buddy);
+    if (it == freeLists[level].end()) {
+      break;
+    }
+    freeLists[level].erase(it);
+    offset = std::min(offset, buddy);
+    level--;
+  }
+  freeLists[level].insert(offset);
+}
+
+VvtAllocator::VvtAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+    : physicalDevice{physicalDevice}, device{device} {
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+  heapStats.resize(memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    heapStats[i].flags = memoryProperties.memoryHeaps[i].flags;
+    heapStats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+  }
+}
+
+VvtAllocator::~VvtAllocator() {
+  for (auto &pool : pools) {
+    for (auto &block : pool.blocks) {
+      if (block.memory != VK_NULL_HANDLE) {
+        assert(block.buddy->isEmpty() && "Device memory is still in use!");
+        vkFreeMemory(device, block.memory, nullptr);
+      }
+    }
+  }
+}
+
+uint32_t VvtAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+
+  throw std::runtime_error("failed to find suitable memory type!");
+}
+
+uint32_t VvtAllocator::getPool(uint32_t memoryType, bool optimalImages) {
+  for (uint32_t i = 0; i < pools.size(); i++) {
+    if (pools[i].memoryType == memoryType && pools[i].optimalImages == optimalImages) {
+      return i;
+    }
+  }
+
+  // Small heaps (e.g. the 256 MB device local + host visible heap) get smaller blocks
+  Pool pool{};
+  pool.memoryType = memoryType;
+  pool.optimalImages = optimalImages;
+  pool.blockSize = std::max(
+      std::min(MAX_BLOCK_SIZE, previousPowerOfTwo(memoryProperties.memoryHeaps[getHeapIndex(memoryType)].size / 8)),
+      MIN_ALLOCATION_SIZE);
+  pools.push_back(std::move(pool));
+  return static_cast<uint32_t>(pools.size() - 1);
+}
+
+VkDeviceMemory VvtAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void **mapped) {
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryType;
+
+  VkDeviceMemory memory;
+  if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate device memory!");
+  }
+
+  *mapped = nullptr;
+  if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+      vkFreeMemory(device, memory, nullptr);
+      throw std::runtime_error("failed to map device memory!");
+    }
+  }
+
+  HeapStats &stats = heapStats[getHeapIndex(memoryType)];
+  stats.reservedBytes += size;
+  return memory;
+}
+
+VvtAllocation VvtAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryType) {
+  VvtAllocation allocation{};
+  allocation.memory = allocateDeviceMemory(size, memoryType, &allocation.mapped);
+  allocation.size = size;
+  allocation.memoryType = memoryType;
+  heapStats[getHeapIndex(memoryType)].dedicatedCount++;
+  return allocation;
+}
+
+VvtAllocation VvtAllocator::allocate(
+    const VkMemoryRequirements &requirements,
+    VkMemoryPropertyFlags properties,
+    bool optimalImage) {
+  std::lock_guard<std::mutex> lock{mutex};
+
+  uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+  VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryType].propertyFlags;
+
+  // Flushed ranges of non-coherent memory have to be aligned to nonCoherentAtomSize
+  VkDeviceSize alignment = requirements.alignment;
+  if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+    alignment = std::max(alignment, nonCoherentAtomSize);
+  }
+  VkDeviceSize nodeSize = nextPowerOfTwo(std::max({requirements.size, alignment, MIN_ALLOCATION_SIZE}));
+
+  uint32_t poolIndex = getPool(memoryType, optimalImage);
+  Pool &pool = pools[poolIndex];
+
+  VvtAllocation allocation{};
+  if (nodeSize > pool.blockSize / 2 || (optimalImage && requirements.size >= DEDICATED_IMAGE_SIZE)) {
+    allocation = allocateDedicated(requirements.size, memoryType);
+  } else {
+    bool found = false;
+    for (uint32_t i = 0; i < pool.blocks.size() && !found; i++) {
+      Block &block = pool.blocks[i];
+      if (block.memory != VK_NULL_HANDLE && block.buddy->allocate(nodeSize, allocation.offset)) {
+        allocation.block = i;
+        found = true;
+      }
+    }
+
+    if (!found) {
+      // Reuse the slot of a released block if there is one
+      uint32_t blockIndex = static_cast<uint32_t>(pool.blocks.size());
+      for (uint32_t i = 0; i < pool.blocks.size(); i++) {
+        if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+          blockIndex = i;
+          break;
+        }
+      }
+      if (blockIndex == pool.blocks.size()) {
+        pool.blocks.emplace_back();
+      }
+
+      Block &block = pool.blocks[blockIndex];
+      block.memory = allocateDeviceMemory(pool.blockSize, memoryType, &block.mapped);
+      block.buddy = std::make_unique<BuddyBlock>(pool.blockSize, MIN_ALLOCATION_SIZE);
+      block.buddy->allocate(nodeSize, allocation.offset);
+      allocation.block = blockIndex;
+      heapStats[getHeapIndex(memoryType)].blockCount++;
+    }
+
+    Block &block = pool.blocks[allocation.block];
+    allocation.memory = block.memory;
+    allocation.size = nodeSize;
+    allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + allocation.offset : nullptr;
+    allocation.memoryType = memoryType;
+    allocation.pool = poolIndex;
+  }
+
+  allocation.propertyFlags = typeFlags;
+  allocation.requestedSize = requirements.size;
+
+  HeapStats &stats = heapStats[getHeapIndex(memoryType)];
+  stats.usedBytes += requirements.size;
+  stats.allocationCount++;
+  return allocation;
+}
+
+void VvtAllocator::free(VvtAllocation &allocation) {
+  if (allocation.memory == VK_NULL_HANDLE) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock{mutex};
+
+  HeapStats &stats = heapStats[getHeapIndex(allocation.memoryType)];
+  stats.usedBytes -= allocation.requestedSize;
+  stats.allocationCount--;
+
+  if (allocation.pool == UINT32_MAX) {
+    vkFreeMemory(device, allocation.memory, nullptr);
+    stats.reservedBytes -= allocation.size;
+    stats.dedicatedCount--;
+  } else {
+    Pool &pool = pools[allocation.pool];
+    Block &block = pool.blocks[allocation.block];
+    block.buddy->free(allocation.offset, allocation.size);
+
+    // Empty blocks go back to the driver, except for the last one of the pool to avoid thrashing
+    uint32_t liveBlocks = 0;
+    for (const auto &poolBlock : pool.blocks) {
+      liveBlocks += poolBlock.memory != VK_NULL_HANDLE ? 1 : 0;
+    }
+    if (block.buddy->isEmpty() && liveBlocks > 1) {
+      vkFreeMemory(device, block.memory, nullptr);
+      block.memory = VK_NULL_HANDLE;
+      block.mapped = nullptr;
+      block.buddy.reset();
+      stats.reservedBytes -= pool.blockSize;
+      stats.blockCount--;
+    }
+  }
+
+  allocation = VvtAllocation{};
+}
+
+std::vector<VvtAllocator::HeapStats> VvtAllocator::getHeapStats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return heapStats;
+}
+
+uint32_t VvtAllocator::getDeviceMemoryCount() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  uint32_t count = 0;
+  for (const auto &stats : heapStats) {
+    count += stats.blockCount + stats.dedicatedCount;
+  }
+  return count;
+}
+
+}  // namespace vvt
@@ -0,0 +1,121 @@
+#pragma once
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace vvt {
+
+// Memory of a buffer or image: either a range of a pooled block or a dedicated VkDeviceMemory
+struct VvtAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;  // Reserved for this allocation, at least the requested size
+  void *mapped = nullptr;  // Start of the range for host visible memory, which stays mapped
+  VkMemoryPropertyFlags propertyFlags = 0;
+
+  // Bookkeeping of the allocator
+  uint32_t memoryType = 0;
+  uint32_t pool = UINT32_MAX;  // UINT32_MAX for dedicated allocations
+  uint32_t block = 0;
+  VkDeviceSize requestedSize = 0;
+};
+
+/*
+ * Sub-allocates buffers and images from large blocks per memory type, so we stay far below
+ * maxMemoryAllocationCount. Blocks are split with a buddy allocator, which keeps every range aligned
+ * to its (power of two) size. Linear resources and optimal images get separate pools, so
+ * bufferImageGranularity never has to be considered. Big allocations get their own VkDeviceMemory.
+ *
+ * Host visible blocks are mapped once for their whole lifetime, since a VkDeviceMemory can only be
+ * mapped once at a time and is shared by many allocations.
+ */
+class VvtAllocator {
+ public:
+  static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64ull << 20;
+  static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+  // Images at least this large always get a dedicated allocation
+  static constexpr VkDeviceSize DEDICATED_IMAGE_SIZE = 16ull << 20;
+
+  struct HeapStats {
+    VkMemoryHeapFlags flags = 0;
+    VkDeviceSize heapSize = 0;
+    VkDeviceSize usedBytes = 0;  // Requested by live allocations
+    VkDeviceSize reservedBytes = 0;  // Allocated from the driver, blocks and dedicated allocations
+    uint32_t allocationCount = 0;
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+  };
+
+  VvtAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+  ~VvtAllocator();
+
+  VvtAllocator(const VvtAllocator &) = delete;
+  VvtAllocator &operator=(const VvtAllocator &) = delete;
+
+  // Thread safe
+  VvtAllocation allocate(
+      const VkMemoryRequirements &requirements,
+      VkMemoryPropertyFlags properties,
+      bool optimalImage);
+  void free(VvtAllocation &allocation);
+
+  std::vector<HeapStats> getHeapStats() const;
+  uint32_t getDeviceMemoryCount() const;
+
+ private:
+  // Free ranges per level, level 0 is the whole block and every level halves the range size
+  class BuddyBlock {
+   public:
+    BuddyBlock(VkDeviceSize size, VkDeviceSize minNodeSize);
+
+    bool allocate(VkDeviceSize nodeSize, VkDeviceSize &offset);
+    void free(VkDeviceSize offset, VkDeviceSize nodeSize);
+    bool isEmpty() const { return freeBytes == size; }
+
+   private:
+    uint32_t getLevel(VkDeviceSize nodeSize) const;
+
+    VkDeviceSize size;
+    VkDeviceSize freeBytes;
+    std::vector<std::set<VkDeviceSize>> freeLists;
+  };
+
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void *mapped = nullptr;
+    std::unique_ptr<BuddyBlock> buddy;
+  };
+
+  struct Pool {
+    uint32_t memoryType = 0;
+    bool optimalImages = false;
+    VkDeviceSize blockSize = 0;
+    std::vector<Block> blocks;  // Released blocks leave an empty slot, so block indices stay valid
+  };
+
+  uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+  uint32_t getPool(uint32_t memoryType, bool optimalImages);
+  VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void **mapped);
+  VvtAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryType);
+  uint32_t getHeapIndex(uint32_t memoryType) const {
+    return memoryProperties.memoryTypes[memoryType].heapIndex;
+  }
+
+  VkPhysicalDevice physicalDevice;
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  VkDeviceSize nonCoherentAtomSize;
+
+  mutable std::mutex mutex;
+  std::vector<Pool> pools;
+  std::vector<HeapStats> heapStats;
+};
+
+}  // namespace vvt
@@ -1,13 +1,17 @@
 #include "vvt_app.hpp"
 #include "vvt_buffer.hpp"
+#include "vvt_profiler.hpp"
 
 // std
 #include <cassert>
+#include <cfloat>
 #include <stdexcept>
 #include <array>
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <string>
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -29,18 +33,80 @@ namespace vvt {
 		alignas(16) glm::mat4 view{ 1.0f };
 	};
 
-	VvtApp::VvtApp()
+	VvtAppSettings VvtAppSettings::fromCommandLine(int argc, char* argv[])
 	{
+		VvtAppSettings settings{};
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (argument == "--headless")
+			{
+				settings.headless = true;
+			}
+			else if (argument == "--frames" && hasValue)
+			{
+				settings.headlessFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (argument == "--width" && hasValue)
+			{
+				settings.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (argument == "--height" && hasValue)
+			{
+				settings.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (argument == "--frame-times-csv" && hasValue)
+			{
+				settings.frameTimesCsv = argv[++i];
+			}
+			else if (argument == "--vertex-layout" && hasValue)
+			{
+				std::string layout = argv[++i];
+				if (layout == "full")
+				{
+					settings.pointModelLayout = VvtModel::VertexLayout::full();
+				}
+				else if (layout == "compact" || layout == "compact-half")
+				{
+					settings.pointModelLayout = VvtModel::VertexLayout::compactLayout(layout == "compact-half", false);
+				}
+				else
+				{
+					throw std::invalid_argument("Unknown vertex layout: " + layout);
+				}
+			}
+			else
+			{
+				throw std::invalid_argument("Unknown or incomplete command line argument: " + argument);
+			}
+		}
+
+		if (settings.width == 0 || settings.height == 0)
+		{
+			throw std::invalid_argument("The render extent must not be empty!");
+		}
+		return settings;
+	}
+
+	VvtApp::VvtApp(const VvtAppSettings& appSettings) : settings{ appSettings }
+	{
+		VVT_PROFILE_SCOPE("VvtApp::VvtApp (after device)");
 		loadTextures();
 
+		// Global sets + one SH coefficient set per sphere function and frame in flight
 		globalPool = VvtDescriptorPool::Builder(vvtDevice)
-			.setMaxSets(2 * VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets((2 + MAX_SPHERE_FUNCTIONS) * VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (2 + MAX_SPHERE_FUNCTIONS) * VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 * VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 		initDescriptorsAndUBOs();
 
-		initImgui();
+		// There is no window to show the UI in when headless
+		if (!settings.headless)
+		{
+			initImgui();
+		}
 		loadGameObjects();
 		initVisualizations();
 
@@ -59,9 +125,19 @@ namespace vvt {
 
 		simpleRenderSystem = std::make_unique<SimpleRenderSystem>(
 			vvtDevice, 
-			vvtRenderer.getSwapChainRenderPass(),
-			vvtRenderer.getSwapChainRenderPass(),
-			globalSetLayout->getDescriptorSetLayout());
+			threadPool,
+			vvtRenderer->getSwapChainRenderPass(),
+			vvtRenderer->getSwapChainRenderPass(),
+			globalSetLayout->getDescriptorSetLayout(),
+			shCoefficientSetLayout->getDescriptorSetLayout(),
+			settings.pointModelLayout);
+
+		if (settings.headless)
+		{
+			runHeadless();
+			return;
+		}
+		simpleRenderSystem->watchShaders(shaderManager);
 	
         auto currentTime = std::chrono::high_resolution_clock::now();
 
@@ -70,9 +146,15 @@ namespace vvt {
 		bool show_another_window = false;
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
-		while (!vvtWindow.shouldClose())
+		while (!vvtWindow->shouldClose())
 		{
+			VVT_PROFILE_SCOPE("Frame");
 			glfwPollEvents();
+			// Between frames no command buffer is being recorded, the swapped pipelines are used from the next one on
+			if (shaderManager.poll())
+			{
+				simpleRenderSystem->reloadPipelines(vvtRenderer->getSwapChainRenderPass());
+			}
 
 			renderImGuiWindow();
 
@@ -85,34 +167,15 @@ namespace vvt {
 			updateCamera(frameTime);
 
 			// Render loop
-			if (auto commandBuffer = vvtRenderer.beginFrame()) {
-				int frameIndex = vvtRenderer.getFrameIndex();
-				
-				// Update phase
-				GlobalUbo ubo{};
-				ubo.projection = camera.getProjection();
-				ubo.view = camera.getView();
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
-
-				// Render Scene
-				vvtRenderer.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem->renderGameObjects(
-					commandBuffer, 
-					globalDescriptorSets[frameIndex], 
-					gameObjects,
-					sphereFunctions,
-					camera, 
-					frameTime,
-					viewerObject.get());
-				vvtRenderer.endSwapChainRenderPass(commandBuffer);
+			if (auto commandBuffer = vvtRenderer->beginFrame()) {
+				renderScene(commandBuffer, frameTime);
 
 				// Draw ImGui Window
-				vvtRenderer.beginImGuiRenderPass(commandBuffer);
+				vvtRenderer->beginImGuiRenderPass(commandBuffer);
 				ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-				vvtRenderer.endImGuiRenderPass(commandBuffer);
+				vvtRenderer->endImGuiRenderPass(commandBuffer);
 
-				vvtRenderer.endFrame();
+				vvtRenderer->endFrame();
 			}
 		}
 		vkDeviceWaitIdle(vvtDevice.device());
@@ -122,6 +185,114 @@ namespace vvt {
 	}
 
 
+	/* Updates the frame's UBO and records the scene render pass */
+	void VvtApp::renderScene(VkCommandBuffer commandBuffer, float frameTime)
+	{
+		VVT_PROFILE_FUNCTION();
+		int frameIndex = vvtRenderer->getFrameIndex();
+
+		// Update phase
+		GlobalUbo ubo{};
+		ubo.projection = camera.getProjection();
+		ubo.view = camera.getView();
+		uboBuffers[frameIndex]->writeToBuffer(&ubo);
+		uboBuffers[frameIndex]->flush();
+
+		// Render Scene
+		// The scene draws are cached in secondary command buffers, camera movement only changes the UBO
+		vvtRenderer->beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		simpleRenderSystem->renderGameObjects(
+			commandBuffer, 
+			vvtRenderer->getSwapChainRenderPass(),
+			globalDescriptorSets[frameIndex], 
+			frameIndex,
+			vvtRenderer->getExtent(),
+			gameObjects,
+			sphereFunctions,
+			camera, 
+			frameTime,
+			viewerObject.get(),
+			vvtRenderer->getGpuProfiler());
+		vvtRenderer->endSwapChainRenderPass(commandBuffer);
+	}
+
+	/*
+	* Renders a fixed amount of frames of the initial scene offscreen and reports the frame times. CPU time covers
+	* recording and submitting a frame, GPU time is measured with timestamps and becomes available
+	* MAX_FRAMES_IN_FLIGHT frames later, so the last frames have none.
+	*/
+	void VvtApp::runHeadless()
+	{
+		const float fixedFrameTime = 1.0f / 60.0f;
+		const uint32_t frameCount = settings.headlessFrames;
+		std::vector<float> cpuFrameTimes(frameCount, -1.0f);
+		std::vector<float> gpuFrameTimes(frameCount, -1.0f);
+
+		updateCamera(fixedFrameTime);
+
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			// beginFrame waits until the frame slot is free again, which is not part of the CPU time
+			auto commandBuffer = vvtRenderer->beginFrame();
+			auto recordStart = std::chrono::high_resolution_clock::now();
+
+			renderScene(commandBuffer, fixedFrameTime);
+			vvtRenderer->endFrame();
+
+			auto recordEnd = std::chrono::high_resolution_clock::now();
+			cpuFrameTimes[frame] = std::chrono::duration<float, std::milli>(recordEnd - recordStart).count();
+			if (frame >= VvtSwapChain::MAX_FRAMES_IN_FLIGHT)
+			{
+				gpuFrameTimes[frame - VvtSwapChain::MAX_FRAMES_IN_FLIGHT] = vvtRenderer->getGpuFrameTime();
+			}
+		}
+		vkDeviceWaitIdle(vvtDevice.device());
+
+		auto printStatistics = [](const char* name, std::vector<float> times) {
+			times.erase(std::remove_if(times.begin(), times.end(), [](float t) { return t < 0.0f; }), times.end());
+			if (times.empty())
+			{
+				std::cout << name << ": not available" << std::endl;
+				return;
+			}
+			std::sort(times.begin(), times.end());
+			double sum = 0.0;
+			for (float t : times)
+			{
+				sum += t;
+			}
+			std::cout << name << " [ms]: mean " << sum / times.size()
+				<< ", median " << times[times.size() / 2]
+				<< ", p95 " << times[std::min(times.size() - 1, times.size() * 95 / 100)]
+				<< ", max " << times.back() << std::endl;
+		};
+
+		std::cout << "Headless run: " << frameCount << " frames at " << settings.width << "x" << settings.height
+			<< " on " << vvtDevice.properties.deviceName << std::endl;
+		printStatistics("CPU frame time", cpuFrameTimes);
+		printStatistics("GPU frame time", gpuFrameTimes);
+
+		if (!settings.frameTimesCsv.empty())
+		{
+			std::ofstream csv{ settings.frameTimesCsv };
+			if (!csv.is_open())
+			{
+				throw std::runtime_error("Failed to open " + settings.frameTimesCsv);
+			}
+
+			csv << "frame,cpu_ms,gpu_ms\n";
+			for (uint32_t frame = 0; frame < frameCount; frame++)
+			{
+				csv << frame << "," << cpuFrameTimes[frame] << ",";
+				if (gpuFrameTimes[frame] >= 0.0f)
+				{
+					csv << gpuFrameTimes[frame];
+				}
+				csv << "\n";
+			}
+		}
+	}
+
 	void VvtApp::initImgui()
 	{
 		// Create descriptor pool for ImGui
@@ -160,7 +331,7 @@ namespace vvt {
 		ImGui::StyleColorsDark();
 
 		// Platform/renderer bindings
-		ImGui_ImplGlfw_InitForVulkan(vvtWindow.getGLFWwindow(), true);
+		ImGui_ImplGlfw_InitForVulkan(vvtWindow->getGLFWwindow(), true);
 		ImGui_ImplVulkan_InitInfo init_info = {};
 		init_info.Instance = vvtDevice.getInstance();
 		init_info.PhysicalDevice = vvtDevice.getPhysicalDevice();
@@ -172,7 +343,7 @@ namespace vvt {
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 
 		// ImGui Vulkan initialization
-		ImGui_ImplVulkan_Init(&init_info, vvtRenderer.getImGuiRenderPass());
+		ImGui_ImplVulkan_Init(&init_info, vvtRenderer->getImGuiRenderPass());
 
 		// Upload fonts to GPU
 		VkCommandBuffer command_buffer = vvtDevice.beginSingleTimeCommands();
@@ -186,8 +357,9 @@ namespace vvt {
 	/* Initializer for game objects that are always loaded into the scene */
 	void VvtApp::loadGameObjects()
     {
+		VVT_PROFILE_FUNCTION();
 		// Example model
-		//std::shared_ptr<VvtModel> exampleModel = VvtModel::createModelFromFile(vvtDevice, "../Models/cube.obj");
+		//std::shared_ptr<VvtModel> exampleModel = VvtModel::createModelFromFile(vvtDevice, threadPool, "../Models/cube.obj");
 
 		//auto exampleCube = VvtGameObject::createGameObject();
 		//exampleCube.modelPath = std::string("../Models/cube.obj");
@@ -201,6 +373,7 @@ namespace vvt {
 	/* Initialize textures */
 	void VvtApp::loadTextures()
 	{
+		VVT_PROFILE_FUNCTION();
 		const char* test = "../Textures/pepe.jpg";
 		testTexture = std::make_unique<VvtTexture>(vvtDevice, test, TEXTURE_TYPE_STANDARD_2D);
 	}
@@ -228,6 +401,10 @@ namespace vvt {
 			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)	// Texture sampler
 			.build());
 
+		shCoefficientSetLayout = VvtDescriptorSetLayout::Builder(vvtDevice)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)	// SH coefficients of a reconstruction
+			.build();
+
 		// Write to descriptor sets
 		globalDescriptorSets.resize(VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
@@ -245,18 +422,24 @@ namespace vvt {
 
 	void VvtApp::initVisualizations()
 	{
-		std::shared_ptr<VvtModel> pointModel = VvtModel::createModelFromFile(vvtDevice, "../Models/sphere.obj");
+		VVT_PROFILE_FUNCTION();
+		std::shared_ptr<VvtModel> pointModel = VvtModel::createModelFromFile(vvtDevice, threadPool, "../Models/sphere.obj", settings.pointModelLayout);
 
+		// The function id keys the coefficient cache, change it whenever the function changes
 		sh::SphericalFunction func = [](double phi, double theta) { return glm::sin(phi) * glm::cos(phi); };
-		SphereContainer sphereFunc1 = { {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f }, 3.0f, func, pointModel };
-		sphereFunctions.push_back(sphereFunc1);
+		SphereContainer sphereFunc1 = { vvtDevice, threadPool, coefficientCache, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f }, 3.0f, func, "sin(phi) * cos(phi)", pointModel };
+		sphereFunctions.push_back(std::move(sphereFunc1));
 		sphereFunctions.back().generateSpherePoints();
+		sphereFunctions.back().initCoefficientBuffers(*shCoefficientSetLayout, *globalPool);
+
+		assert(sphereFunctions.size() <= static_cast<size_t>(MAX_SPHERE_FUNCTIONS) && "Global descriptor pool is too small for this many sphere functions!");
 	}
 
 
 
 	void VvtApp::renderImGuiWindow()
 	{
+		VVT_PROFILE_FUNCTION();
 		ImGui_ImplVulkan_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
@@ -282,6 +465,151 @@ namespace vvt {
 			{
 				sphereFunctions[0].updateRotation();
 			}
+
+			const char* projectionMethods[] = { "Monte Carlo", "Gauss-Legendre", "Lebedev" };
+			int projectionMethod = sphereFunctions[0].getProjectionMethod();
+			if (ImGui::Combo("Projection", &projectionMethod, projectionMethods, IM_ARRAYSIZE(projectionMethods)))
+			{
+				sphereFunctions[0].setProjectionMethod(static_cast<ProjectionMethod>(projectionMethod));
+			}
+
+			// Surfaces are a single icosphere mesh per function instead of a point glyph per sample
+			const char* visualizationModes[] = { "Point glyphs", "Surface |f|", "Coloured sphere" };
+			int visualizationMode = sphereFunctions[0].getVisualizationMode();
+			if (ImGui::Combo("Visualization", &visualizationMode, visualizationModes, IM_ARRAYSIZE(visualizationModes)))
+			{
+				sphereFunctions[0].setVisualizationMode(static_cast<VisualizationMode>(visualizationMode));
+			}
+
+			// Equal-area schemes spread the points evenly instead of crowding them at the poles, surfaces always use the icosphere
+			const char* samplingSchemes[] = { "(phi, theta) grid", "Fibonacci lattice", "HEALPix", "Icosphere" };
+			int samplingScheme = sphereFunctions[0].getSamplingScheme();
+			int pointCount = static_cast<int>(sphereFunctions[0].getPointCount());
+			bool samplingChanged = ImGui::Combo("Sampling", &samplingScheme, samplingSchemes, IM_ARRAYSIZE(samplingSchemes));
+			ImGui::SliderInt("Points", &pointCount, 500, 20000);
+			samplingChanged |= ImGui::IsItemDeactivatedAfterEdit();
+			if (samplingChanged)
+			{
+				sphereFunctions[0].setSampling(static_cast<SamplingScheme>(samplingScheme), static_cast<uint32_t>(pointCount));
+			}
+			// Schemes round the target count, shown for the slider value while it is still being dragged
+			ImGui::Text("Sampled points: %u", ShDirections::sampleCount(sphereFunctions[0].getSampledScheme(), static_cast<uint32_t>(pointCount)));
+
+			const ShProjection& projection = sphereFunctions[0].getProjection();
+			ImGui::Text("%s", projection.description.c_str());
+			ImGui::Text("Function evaluations: %zu", projection.functionEvaluations);
+			ImGui::Text("Estimated coefficient error: %.3e", projection.errorEstimate);
+
+			// Every combination is a pipeline variant with its own specialization constants, created when first used
+			SimpleRenderSystem::PointStyle pointStyle = simpleRenderSystem->getPointStyle();
+			const char* colorModes[] = { "Signed red/blue", "Colour map" };
+			int colorMode = pointStyle.colorMode;
+			bool pointStyleChanged = ImGui::SliderInt("Reconstruction order", &pointStyle.reconstructionOrder, 0, BASIS_FUNCTION_MAX_ORDER);
+			if (ImGui::Combo("Colours", &colorMode, colorModes, IM_ARRAYSIZE(colorModes)))
+			{
+				pointStyle.colorMode = static_cast<ColorMode>(colorMode);
+				pointStyleChanged = true;
+			}
+			pointStyleChanged |= ImGui::Checkbox("Lighting", &pointStyle.lighting);
+			if (pointStyleChanged)
+			{
+				simpleRenderSystem->setPointStyle(pointStyle);
+			}
+
+			// Editing a coefficient only rewrites the coefficient UBO, the reconstruction is evaluated on the GPU
+			if (ImGui::CollapsingHeader("SH Coefficients"))
+			{
+				std::vector<double>& coeffs = sphereFunctions[0].getCoefficients();
+				bool coeffsChanged = false;
+				for (int l = 0; l <= BASIS_FUNCTION_MAX_ORDER; l++)
+				{
+					for (int m = -l; m <= l; m++)
+					{
+						std::string label = "l = " + std::to_string(l) + ", m = " + std::to_string(m);
+						coeffsChanged |= ImGui::DragScalar(label.c_str(), ImGuiDataType_Double, &coeffs[sh::GetIndex(l, m)], 0.005f, nullptr, nullptr, "%.4f");
+					}
+				}
+				if (coeffsChanged)
+				{
+					sphereFunctions[0].updateCoefficients();
+				}
+			}
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Performance"))
+		{
+			ImGui::Text("CPU frame time: %.3f ms (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+			ImGui::Text("Scene command buffers recorded: %u", simpleRenderSystem->getSceneRecordCount());
+			VvtPipelineCache& pipelineCache = vvtDevice.getPipelineCache();
+			ImGui::Text("Pipelines created: %u in %.1f ms (%s pipeline cache), %u point style variants", pipelineCache.getPipelineCount(),
+				pipelineCache.getCreationMilliseconds(), pipelineCache.isWarm() ? "warm" : "cold", simpleRenderSystem->getPipelineVariantCount());
+			if (!shaderManager.getStatus().empty())
+			{
+				ImGui::TextWrapped("Shader hot reload: %s", shaderManager.getStatus().c_str());
+			}
+
+			// Heaps without any allocation are left out
+			ImGui::Text("Device memory allocations: %u", vvtDevice.getAllocator().getDeviceMemoryCount());
+			std::vector<VvtAllocator::HeapStats> heapStats = vvtDevice.getAllocator().getHeapStats();
+			for (size_t i = 0; i < heapStats.size(); i++)
+			{
+				const VvtAllocator::HeapStats& heap = heapStats[i];
+				if (heap.reservedBytes == 0)
+				{
+					continue;
+				}
+				ImGui::Text("Heap %zu (%s): %.1f / %.1f MB used, %u allocations, %u blocks, %u dedicated",
+					i, (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host",
+					heap.usedBytes / (1024.0 * 1024.0), heap.reservedBytes / (1024.0 * 1024.0),
+					heap.allocationCount, heap.blockCount, heap.dedicatedCount);
+			}
+			VvtUploadManager& uploadManager = vvtDevice.getUploadManager();
+			ImGui::Text("Upload batches submitted: %llu (%s)", static_cast<unsigned long long>(uploadManager.getSubmittedBatchCount()),
+				uploadManager.hasDedicatedTransferQueue() ? "dedicated transfer queue" : "graphics queue");
+			VvtStagingRing& stagingRing = vvtDevice.getStagingRing();
+			ImGui::Text("Staging ring: %.1f / %.1f MB in flight, %llu temporary staging buffers", stagingRing.getUsedBytes() / (1024.0 * 1024.0),
+				stagingRing.getSize() / (1024.0 * 1024.0), static_cast<unsigned long long>(uploadManager.getTemporaryStagingCount()));
+
+			VvtGpuProfiler& gpuProfiler = vvtRenderer->getGpuProfiler();
+			if (!gpuProfiler.isSupported())
+			{
+				ImGui::TextWrapped("The graphics queue of this device doesn't support timestamp queries, no GPU times available.");
+			}
+			else
+			{
+				for (const auto& scope : gpuProfiler.getScopes())
+				{
+					ImGui::Indent(12.0f * scope.depth + 1.0f);
+					ImGui::Text("%s: %.3f ms (avg. %.3f ms)", scope.name.c_str(), glm::max(gpuProfiler.getLatestTime(scope), 0.0f), glm::max(scope.getAverage(), 0.0f));
+					// Frames that didn't record the scope are drawn as 0
+					ImGui::PlotLines(
+						("##" + scope.name).c_str(),
+						[](void* data, int index) { return glm::max(static_cast<const float*>(data)[index], 0.0f); },
+						const_cast<float*>(scope.times.data()), static_cast<int>(scope.times.size()),
+						static_cast<int>(gpuProfiler.getHistoryOffset()),
+						nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+					ImGui::Unindent(12.0f * scope.depth + 1.0f);
+				}
+
+				if (ImGui::Button("Export CSV"))
+				{
+					try
+					{
+						gpuProfiler.writeCsv(GPU_PROFILE_CSV);
+						gpuProfileStatus = std::string("Written to ") + GPU_PROFILE_CSV;
+					}
+					catch (const std::exception& e)
+					{
+						gpuProfileStatus = e.what();
+					}
+				}
+				if (!gpuProfileStatus.empty())
+				{
+					ImGui::SameLine();
+					ImGui::Text("%s", gpuProfileStatus.c_str());
+				}
+			}
 			ImGui::EndTabItem();
 		}
 
@@ -295,10 +623,13 @@ namespace vvt {
 	/* Update camera view/model matrix */
 	void VvtApp::updateCamera(float frameTime)
 	{
-		float aspect = vvtRenderer.getAspectRatio();
+		float aspect = vvtRenderer->getAspectRatio();
 
 		// Update camera model (game object that contains camera
-		cameraController.moveInPlaneXZ(vvtWindow.getGLFWwindow(), frameTime, *viewerObject);
+		if (vvtWindow)
+		{
+			cameraController.moveInPlaneXZ(vvtWindow->getGLFWwindow(), frameTime, *viewerObject);
+		}
 		// Update camera view matrix
 		camera.setViewYXZ(viewerObject->transform.translation, viewerObject->transform.rotation);
 		camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 1000.f);
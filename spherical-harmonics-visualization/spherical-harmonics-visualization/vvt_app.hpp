@@ -8,23 +8,48 @@
 #include "vvt_texture.hpp"
 #include "keyboard_movement_controller.hpp"
 #include "simple_render_system.hpp"
+#include "vvt_shader_manager.hpp"
 #include "sphere_container.hpp"
+#include "vvt_thread_pool.hpp"
+#include "sh_coefficient_cache.hpp"
 
 
 // std 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <fstream>
 
 namespace vvt {
+
+	struct VvtAppSettings {
+		uint32_t width = 1200;
+		uint32_t height = 900;
+
+		// Headless runs render a fixed amount of frames offscreen, without window or UI, and report frame times
+		bool headless = false;
+		uint32_t headlessFrames = 500;
+		std::string frameTimesCsv;	// Per-frame times of a headless run are written here if not empty
+
+		// Vertex layout of the point model, the glyph shaders use neither its colors nor its uvs
+		VvtModel::VertexLayout pointModelLayout = VvtModel::VertexLayout::compactLayout(false, false);
+
+		// --headless, --frames <count>, --width <pixels>, --height <pixels>, --frame-times-csv <path>,
+		// --vertex-layout <full|compact|compact-half>
+		static VvtAppSettings fromCommandLine(int argc, char* argv[]);
+	};
+
 	class VvtApp
 	{
 	public:
 		const float MAX_FRAME_TIME = .1f;
-		static constexpr int WIDTH = 1200;
-		static constexpr int HEIGHT = 900;
+		static constexpr int MAX_SPHERE_FUNCTIONS = 4;
+		static constexpr const char* COEFFICIENT_CACHE_DIRECTORY = "../Cache";
+		static constexpr const char* PIPELINE_CACHE_FILE = "../Cache/pipeline_cache.bin";
+		static constexpr const char* GPU_PROFILE_CSV = "gpu_profile.csv";
 
-		VvtApp();
+		VvtApp(const VvtAppSettings& appSettings = {});
 		~VvtApp();
 
 		VvtApp(const VvtApp&) = delete;
@@ -40,30 +65,40 @@ namespace vvt {
 
 		void initVisualizations();
 
+		void runHeadless();
+		void renderScene(VkCommandBuffer commandBuffer, float frameTime);
 		void renderImGuiWindow();
 
 		void updateCamera(float frameTime);
 
-		VvtWindow vvtWindow{ WIDTH, HEIGHT, "SH Visualizations" };
-		VvtDevice vvtDevice{ vvtWindow };
-		VvtRenderer vvtRenderer{ vvtWindow, vvtDevice };
+		VvtAppSettings settings;
+		std::unique_ptr<VvtWindow> vvtWindow{ settings.headless ? nullptr : std::make_unique<VvtWindow>(settings.width, settings.height, "SH Visualizations") };
+		VvtDevice vvtDevice{ vvtWindow.get(), PIPELINE_CACHE_FILE };
+		std::unique_ptr<VvtRenderer> vvtRenderer{ settings.headless
+			? std::make_unique<VvtRenderer>(vvtDevice, VkExtent2D{ settings.width, settings.height })
+			: std::make_unique<VvtRenderer>(*vvtWindow, vvtDevice) };
+		VvtThreadPool threadPool{};
+		ShCoefficientCache coefficientCache{ COEFFICIENT_CACHE_DIRECTORY };
 		VvtCamera camera;
 		std::unique_ptr<SimpleRenderSystem> simpleRenderSystem;
+		VvtShaderManager shaderManager{ vvtDevice.getPipelineCache() };
 		std::unique_ptr<VvtGameObject> viewerObject{};
 
 		// Order of declarations matter!
 		std::unique_ptr<VvtDescriptorPool> globalPool{};
-		VkDescriptorPool imGuiPool;	 // TODO: make use of VvtDescriptorPool class!
+		VkDescriptorPool imGuiPool = VK_NULL_HANDLE;	 // TODO: make use of VvtDescriptorPool class!
 
 		std::unique_ptr<VvtTexture> testTexture;
 		std::vector<std::unique_ptr<VvtBuffer>> uboBuffers;
 		std::unique_ptr<VvtDescriptorSetLayout> globalSetLayout;
+		std::unique_ptr<VvtDescriptorSetLayout> shCoefficientSetLayout;
 		std::vector<VkDescriptorSet> globalDescriptorSets;
 
 		std::vector<VvtGameObject> gameObjects;
 		std::vector<SphereContainer> sphereFunctions;
 
 		KeyboardMovementController cameraController;
+		std::string gpuProfileStatus;
 	};
 }
 
@@ -48,8 +48,7 @@ namespace vvt {
 
     VvtBuffer::~VvtBuffer() {
         unmap();
-        vkDestroyBuffer(vvtDevice.device(), buffer, nullptr);
-        vkFreeMemory(vvtDevice.device(), memory, nullptr);
+        vvtDevice.destroyBuffer(buffer, memory);
     }
 
     /**
@@ -62,20 +61,22 @@ namespace vvt {
      * @return VkResult of the buffer mapping call
      */
     VkResult VvtBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(vvtDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && memory.memory && "Called map on buffer before create");
+        // The memory is shared with other buffers and mapped by the allocator for its whole lifetime
+        if (!memory.mapped) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(memory.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The allocator keeps the memory itself mapped, this only drops the pointer
      */
     void VvtBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(vvtDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -114,9 +115,9 @@ namespace vvt {
     VkResult VvtBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = memory.memory;
+        mappedRange.offset = memory.offset + offset;
+        mappedRange.size = size == VK_WHOLE_SIZE ? memory.size - offset : size;
         return vkFlushMappedMemoryRanges(vvtDevice.device(), 1, &mappedRange);
     }
 
@@ -134,9 +135,9 @@ namespace vvt {
     VkResult VvtBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = memory.memory;
+        mappedRange.offset = memory.offset + offset;
+        mappedRange.size = size == VK_WHOLE_SIZE ? memory.size - offset : size;
         return vkInvalidateMappedMemoryRanges(vvtDevice.device(), 1, &mappedRange);
     }
 
@@ -45,7 +45,7 @@ namespace vvt {
         VvtDevice& vvtDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VvtAllocation memory;
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "vvt_window.hpp"
+#include "vvt_allocator.hpp"
+#include "vvt_pipeline_cache.hpp"
+#include "vvt_staging_ring.hpp"
+#include "vvt_upload_manager.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,6 +22,7 @@ namespace vvt {
     struct QueueFamilyIndices {
       uint32_t graphicsFamily;
       uint32_t presentFamily;
+      uint32_t transferFamily;  // The graphics family if there is no dedicated transfer family
       bool graphicsFamilyHasValue = false;
       bool presentFamilyHasValue = false;
       bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -31,6 +37,10 @@ namespace vvt {
     #endif
 
       VvtDevice(VvtWindow &window);
+
+      // Without a window the device is headless: no surface, no present queue and no swap chain extension.
+      // The pipeline cache is persisted to pipelineCachePath if one is given
+      explicit VvtDevice(VvtWindow *window, const std::string &pipelineCachePath = {});
       ~VvtDevice();
 
       // Not copyable or movable
@@ -42,8 +52,14 @@ namespace vvt {
       VkSurfaceKHR surface() { return surface_; }
       VkQueue graphicsQueue() { return graphicsQueue_; }
       VkQueue presentQueue() { return presentQueue_; }
+      VkQueue transferQueue() { return transferQueue_; }
       VkInstance getInstance() { return instance; }
       VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+      bool isHeadless() const { return window == nullptr; }
+      VvtAllocator &getAllocator() { return *allocator; }
+      VvtStagingRing &getStagingRing() { return *stagingRing; }
+      VvtUploadManager &getUploadManager() { return *uploadManager; }
+      VvtPipelineCache &getPipelineCache() { return *pipelineCache; }
 
       SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
       uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -51,30 +67,24 @@ namespace vvt {
       VkFormat findSupportedFormat(
           const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-      // Buffer Helper Functions
+      // Buffer Helper Functions, the memory is sub-allocated by the allocator
       void createBuffer(
           VkDeviceSize size,
           VkBufferUsageFlags usage,
           VkMemoryPropertyFlags properties,
           VkBuffer &buffer,
-          VkDeviceMemory &bufferMemory);
+          VvtAllocation &bufferMemory);
+      void destroyBuffer(VkBuffer buffer, VvtAllocation &bufferMemory);
+      // Blocks until the commands have finished, uploads go through the upload manager instead
       VkCommandBuffer beginSingleTimeCommands();
       void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-      void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-      void copyBufferToImage(
-          VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
       void createImageWithInfo(
           const VkImageCreateInfo &imageInfo,
           VkMemoryPropertyFlags properties,
           VkImage &image,
-          VkDeviceMemory &imageMemory);
-
-      void transitionImageLayout(VkImage image, 
-          VkImageLayout oldLayout, 
-          VkImageLayout newLayout,
-          uint32_t levelCount,
-          uint32_t layerCount);
+          VvtAllocation &imageMemory);
+      void destroyImage(VkImage image, VvtAllocation &imageMemory);
 
       VkImageView createImageView(VkImage image, VkFormat format, VkImageViewType imgViewType, uint32_t layerCount);
       
@@ -102,16 +112,21 @@ namespace vvt {
       VkInstance instance;
       VkDebugUtilsMessengerEXT debugMessenger;
       VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-      VvtWindow &window;
+      VvtWindow *window;
       VkCommandPool commandPool;
 
       VkDevice device_;
-      VkSurfaceKHR surface_;
+      VkSurfaceKHR surface_ = VK_NULL_HANDLE;
       VkQueue graphicsQueue_;
       VkQueue presentQueue_;
+      VkQueue transferQueue_;
+      std::unique_ptr<VvtAllocator> allocator;
+      std::unique_ptr<VvtPipelineCache> pipelineCache;
+      std::unique_ptr<VvtStagingRing> stagingRing;
+      std::unique_ptr<VvtUploadManager> uploadManager;
 
       std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_monitor"};
-      const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+      std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
     };
 
 }  // namespace vvt
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "vvt_gpu_profiler.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace vvt {
+
+	float VvtGpuProfiler::ScopeHistory::getAverage() const
+	{
+		double sum = 0.0;
+		uint32_t count = 0;
+		for (float time : times)
+		{
+			if (time >= 0.0f)
+			{
+				sum += time;
+				count++;
+			}
+		}
+		return count > 0 ? static_cast<float>(sum / count) : -1.0f;
+	}
+
+	VvtGpuProfiler::VvtGpuProfiler(VvtDevice& device, uint32_t framesInFlight) : vvtDevice{ device }
+	{
+		frames.resize(framesInFlight);
+
+		// Not every queue supports timestamps, the profiler just stays empty then
+		QueueFamilyIndices queueFamilyIndices = vvtDevice.findPhysicalQueueFamilies();
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(vvtDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(vvtDevice.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamilies[queueFamilyIndices.graphicsFamily].timestampValidBits;
+		if (validBits == 0)
+		{
+			return;
+		}
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		timestampPeriod = vvtDevice.properties.limits.timestampPeriod;
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * MAX_SCOPES_PER_FRAME * framesInFlight;
+
+		if (vkCreateQueryPool(vvtDevice.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool!");
+		}
+	}
+
+	VvtGpuProfiler::~VvtGpuProfiler()
+	{
+		if (queryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(vvtDevice.device(), queryPool, nullptr);
+		}
+	}
+
+	void VvtGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+		assert(frameIndex >= 0 && frameIndex < static_cast<int>(frames.size()) && "Frame index out of range!");
+
+		currentFrameIndex = frameIndex;
+		FrameQueries& frame = frames[frameIndex];
+		collectResults(frame);
+
+		frame.recordedScopes.clear();
+		frame.openScopes.clear();
+		frame.usedQueries = 0;
+		vkCmdResetQueryPool(commandBuffer, queryPool, 2 * MAX_SCOPES_PER_FRAME * frameIndex, 2 * MAX_SCOPES_PER_FRAME);
+	}
+
+	void VvtGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name)
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+		assert(currentFrameIndex >= 0 && "beginFrame has to be called before the first scope!");
+
+		FrameQueries& frame = frames[currentFrameIndex];
+		if (frame.usedQueries + 2 > 2 * MAX_SCOPES_PER_FRAME)
+		{
+			// Out of queries, the scope is dropped but still has to be balanced by endScope
+			frame.openScopes.push_back(UINT32_MAX);
+			return;
+		}
+
+		RecordedScope recorded{};
+		recorded.scopeIndex = getScopeIndex(name, static_cast<uint32_t>(frame.openScopes.size()));
+		recorded.beginQuery = 2 * MAX_SCOPES_PER_FRAME * currentFrameIndex + frame.usedQueries;
+		recorded.endQuery = recorded.beginQuery + 1;
+		frame.usedQueries += 2;
+
+		frame.openScopes.push_back(static_cast<uint32_t>(frame.recordedScopes.size()));
+		frame.recordedScopes.push_back(recorded);
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, recorded.beginQuery);
+	}
+
+	void VvtGpuProfiler::endScope(VkCommandBuffer commandBuffer)
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+
+		FrameQueries& frame = frames[currentFrameIndex];
+		assert(!frame.openScopes.empty() && "endScope without matching beginScope!");
+
+		uint32_t recordedIndex = frame.openScopes.back();
+		frame.openScopes.pop_back();
+		if (recordedIndex == UINT32_MAX)
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frame.recordedScopes[recordedIndex].endQuery);
+	}
+
+	VvtGpuProfiler::ScopeCapture VvtGpuProfiler::beginCapture() const
+	{
+		ScopeCapture capture{};
+		if (!isSupported())
+		{
+			return capture;
+		}
+
+		const FrameQueries& frame = frames[currentFrameIndex];
+		capture.frameIndex = currentFrameIndex;
+		capture.firstQuery = frame.usedQueries;
+		capture.depth = static_cast<uint32_t>(frame.openScopes.size());
+		return capture;
+	}
+
+	void VvtGpuProfiler::endCapture(ScopeCapture& capture) const
+	{
+		if (!isSupported())
+		{
+			return;
+		}
+		assert(capture.frameIndex == currentFrameIndex && "A capture has to end in the frame it began in!");
+
+		const FrameQueries& frame = frames[currentFrameIndex];
+		uint32_t firstQuery = 2 * MAX_SCOPES_PER_FRAME * currentFrameIndex + capture.firstQuery;
+		for (const auto& recorded : frame.recordedScopes)
+		{
+			if (recorded.beginQuery >= firstQuery)
+			{
+				capture.scopeIndices.push_back(recorded.scopeIndex);
+				capture.queries.push_back(recorded.beginQuery);
+				capture.queries.push_back(recorded.endQuery);
+			}
+		}
+		capture.endQuery = frame.usedQueries;
+	}
+
+	bool VvtGpuProfiler::replayCapture(const ScopeCapture& capture)
+	{
+		if (!isSupported())
+		{
+			return true;
+		}
+
+		FrameQueries& frame = frames[currentFrameIndex];
+		if (capture.frameIndex != currentFrameIndex || capture.firstQuery != frame.usedQueries || capture.depth != frame.openScopes.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < capture.scopeIndices.size(); i++)
+		{
+			frame.recordedScopes.push_back({ capture.scopeIndices[i], capture.queries[2 * i], capture.queries[2 * i + 1] });
+		}
+		frame.usedQueries = capture.endQuery;
+		return true;
+	}
+
+	/* Only called for a frame slot whose fence was waited on, so the results are available without waiting */
+	void VvtGpuProfiler::collectResults(FrameQueries& frame)
+	{
+		if (frame.recordedScopes.empty())
+		{
+			return;
+		}
+		assert(frame.openScopes.empty() && "Every scope of a frame has to be ended!");
+
+		uint32_t firstQuery = frame.recordedScopes.front().beginQuery;
+		std::vector<uint64_t> timestamps(frame.usedQueries);
+		VkResult result = vkGetQueryPoolResults(
+			vvtDevice.device(),
+			queryPool,
+			firstQuery, frame.usedQueries,
+			timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+
+		uint32_t historyIndex = static_cast<uint32_t>(completedFrames % HISTORY_LENGTH);
+		for (auto& scope : scopes)
+		{
+			scope.times[historyIndex] = -1.0f;
+		}
+
+		for (const auto& recorded : frame.recordedScopes)
+		{
+			uint64_t ticks = (timestamps[recorded.endQuery - firstQuery] - timestamps[recorded.beginQuery - firstQuery]) & timestampMask;
+			float milliseconds = static_cast<float>(static_cast<double>(ticks) * timestampPeriod * 1e-6);
+
+			// Scopes recorded several times per frame are summed up
+			float& time = scopes[recorded.scopeIndex].times[historyIndex];
+			time = (time < 0.0f ? 0.0f : time) + milliseconds;
+		}
+		completedFrames++;
+	}
+
+	uint32_t VvtGpuProfiler::getScopeIndex(const char* name, uint32_t depth)
+	{
+		for (uint32_t i = 0; i < scopes.size(); i++)
+		{
+			if (scopes[i].name == name)
+			{
+				return i;
+			}
+		}
+
+		ScopeHistory scope{};
+		scope.name = name;
+		scope.depth = depth;
+		scope.times.assign(HISTORY_LENGTH, -1.0f);
+		scopes.push_back(std::move(scope));
+		return static_cast<uint32_t>(scopes.size() - 1);
+	}
+
+	const VvtGpuProfiler::ScopeHistory* VvtGpuProfiler::findScope(const std::string& name) const
+	{
+		for (const auto& scope : scopes)
+		{
+			if (scope.name == name)
+			{
+				return &scope;
+			}
+		}
+		return nullptr;
+	}
+
+	float VvtGpuProfiler::getLatestTime(const ScopeHistory& scope) const
+	{
+		if (completedFrames == 0)
+		{
+			return -1.0f;
+		}
+		return scope.times[(completedFrames - 1) % HISTORY_LENGTH];
+	}
+
+	void VvtGpuProfiler::writeCsv(const std::string& filepath) const
+	{
+		std::ofstream csv{ filepath };
+		if (!csv.is_open())
+		{
+			throw std::runtime_error("Failed to open " + filepath);
+		}
+
+		csv << "frame";
+		for (const auto& scope : scopes)
+		{
+			csv << "," << scope.name << "_ms";
+		}
+		csv << "\n";
+
+		// Oldest frame first, frames that didn't record a scope leave its cell empty
+		uint64_t frameCount = completedFrames < HISTORY_LENGTH ? completedFrames : HISTORY_LENGTH;
+		for (uint64_t frame = completedFrames - frameCount; frame < completedFrames; frame++)
+		{
+			csv << frame;
+			for (const auto& scope : scopes)
+			{
+				csv << ",";
+				float time = scope.times[frame % HISTORY_LENGTH];
+				if (time >= 0.0f)
+				{
+					csv << time;
+				}
+			}
+			csv << "\n";
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "vvt_device.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Measures named, possibly nested GPU scopes of a frame with timestamp queries. Every frame in flight owns a
+	* range of the query pool. The results of a frame are read when its slot is reused, after the fence of that
+	* frame was waited on, so reading them never stalls; they show up framesInFlight frames later.
+	*
+	* The times of the last HISTORY_LENGTH frames are kept per scope for graphs and CSV export.
+	*/
+	class VvtGpuProfiler
+	{
+	public:
+		static constexpr uint32_t MAX_SCOPES_PER_FRAME = 32;
+		static constexpr uint32_t HISTORY_LENGTH = 240;
+
+		struct ScopeHistory {
+			std::string name;
+			uint32_t depth = 0;
+			std::vector<float> times;	// Milliseconds, ring buffer indexed like the frame history, negative if the scope wasn't recorded
+
+			// Over the frames of the history that recorded the scope
+			float getAverage() const;
+		};
+
+		// RAII helper for scopes that end with the enclosing block
+		class Scope
+		{
+		public:
+			Scope(VvtGpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name) : profiler{ profiler }, commandBuffer{ commandBuffer } { profiler.beginScope(commandBuffer, name); }
+			~Scope() { profiler.endScope(commandBuffer); }
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			VvtGpuProfiler& profiler;
+			VkCommandBuffer commandBuffer;
+		};
+
+		/*
+		* Scopes recorded into a command buffer that is executed again in later frames, which writes the same
+		* queries again. Only valid in the same frame slot and if the queries before it were used the same way.
+		*/
+		struct ScopeCapture {
+			int frameIndex = -1;
+			uint32_t firstQuery = 0;	// Relative to the range of the frame slot
+			uint32_t endQuery = 0;
+			uint32_t depth = 0;
+			std::vector<uint32_t> scopeIndices;
+			std::vector<uint32_t> queries;	// Begin and end query per scope
+		};
+
+		VvtGpuProfiler(VvtDevice& device, uint32_t framesInFlight);
+		~VvtGpuProfiler();
+
+		VvtGpuProfiler(const VvtGpuProfiler&) = delete;
+		VvtGpuProfiler& operator=(const VvtGpuProfiler&) = delete;
+
+		// False if the graphics queue doesn't support timestamps, all calls are no-ops then
+		bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+		// Collects the results the frame slot holds and resets its queries, call before any scope of the frame
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+		void beginScope(VkCommandBuffer commandBuffer, const char* name);
+		void endScope(VkCommandBuffer commandBuffer);
+
+		// Brackets the recording of a reusable command buffer, the scopes in between end up in the capture
+		ScopeCapture beginCapture() const;
+		void endCapture(ScopeCapture& capture) const;
+		// Accounts for the scopes of a captured command buffer executed again, false if its queries don't fit this frame
+		bool replayCapture(const ScopeCapture& capture);
+
+		const std::vector<ScopeHistory>& getScopes() const { return scopes; }
+		const ScopeHistory* findScope(const std::string& name) const;
+		// Time of the scope in the most recent completed frame, negative if unavailable
+		float getLatestTime(const ScopeHistory& scope) const;
+
+		// Ring buffer position of the oldest frame in the history, as used by ImGui::PlotLines
+		uint32_t getHistoryOffset() const { return static_cast<uint32_t>(completedFrames % HISTORY_LENGTH); }
+		uint64_t getCompletedFrameCount() const { return completedFrames; }
+
+		// One row per frame in the history, one column per scope
+		void writeCsv(const std::string& filepath) const;
+
+	private:
+		struct RecordedScope {
+			uint32_t scopeIndex;
+			uint32_t beginQuery;
+			uint32_t endQuery;
+		};
+
+		struct FrameQueries {
+			std::vector<RecordedScope> recordedScopes;
+			std::vector<uint32_t> openScopes;	// Indices into recordedScopes
+			uint32_t usedQueries = 0;
+		};
+
+		void collectResults(FrameQueries& frame);
+		uint32_t getScopeIndex(const char* name, uint32_t depth);
+
+		VvtDevice& vvtDevice;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		uint64_t timestampMask = 0;
+		double timestampPeriod = 1.0;	// Nanoseconds per tick
+
+		std::vector<FrameQueries> frames;
+		int currentFrameIndex = -1;
+
+		std::vector<ScopeHistory> scopes;
+		uint64_t completedFrames = 0;
+	};
+}
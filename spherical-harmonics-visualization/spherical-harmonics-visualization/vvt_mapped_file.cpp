@@ -0,0 +1,133 @@
+#include "vvt_mapped_file.hpp"
+
+// std
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vvt {
+
+#ifdef _WIN32
+	VvtMappedFile::VvtMappedFile(const std::string& filepath)
+	{
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return;
+		}
+
+		fileHandle = file;
+		mappingHandle = mapping;
+		mappedData = view;
+		mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	}
+
+	void VvtMappedFile::close()
+	{
+		if (mappedData != nullptr)
+		{
+			UnmapViewOfFile(mappedData);
+			CloseHandle(mappingHandle);
+			CloseHandle(fileHandle);
+		}
+		mappedData = nullptr;
+		mappedSize = 0;
+		fileHandle = nullptr;
+		mappingHandle = nullptr;
+	}
+#else
+	VvtMappedFile::VvtMappedFile(const std::string& filepath)
+	{
+		int file = ::open(filepath.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return;
+		}
+
+		struct stat fileStat {};
+		if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			::close(file);
+			return;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		// The mapping stays valid after the descriptor is closed
+		::close(file);
+		if (view == MAP_FAILED)
+		{
+			return;
+		}
+
+		mappedData = view;
+		mappedSize = static_cast<size_t>(fileStat.st_size);
+	}
+
+	void VvtMappedFile::close()
+	{
+		if (mappedData != nullptr)
+		{
+			munmap(const_cast<void*>(mappedData), mappedSize);
+		}
+		mappedData = nullptr;
+		mappedSize = 0;
+	}
+#endif
+
+	VvtMappedFile::~VvtMappedFile()
+	{
+		close();
+	}
+
+	VvtMappedFile::VvtMappedFile(VvtMappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	VvtMappedFile& VvtMappedFile::operator=(VvtMappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(mappedData, other.mappedData);
+			std::swap(mappedSize, other.mappedSize);
+#ifdef _WIN32
+			std::swap(fileHandle, other.fileHandle);
+			std::swap(mappingHandle, other.mappingHandle);
+#endif
+		}
+		return *this;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <string>
+
+namespace vvt {
+
+	/*
+	* Read-only memory mapping of a whole file. The mapping is released on destruction.
+	* Files that don't exist or are empty result in a closed mapping instead of an exception,
+	* so callers can treat them like a cache miss.
+	*/
+	class VvtMappedFile
+	{
+	public:
+		VvtMappedFile() = default;
+		explicit VvtMappedFile(const std::string& filepath);
+		~VvtMappedFile();
+
+		VvtMappedFile(const VvtMappedFile&) = delete;
+		VvtMappedFile& operator=(const VvtMappedFile&) = delete;
+		VvtMappedFile(VvtMappedFile&& other) noexcept;
+		VvtMappedFile& operator=(VvtMappedFile&& other) noexcept;
+
+		bool isOpen() const { return mappedData != nullptr; }
+		const unsigned char* data() const { return static_cast<const unsigned char*>(mappedData); }
+		size_t size() const { return mappedSize; }
+
+		void close();
+
+	private:
+		const void* mappedData = nullptr;
+		size_t mappedSize = 0;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,166 @@
+#include "vvt_mesh_cache.hpp"
+#include "vvt_utils.hpp"
+#include "vvt_profiler.hpp"
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace vvt {
+
+	namespace {
+
+		constexpr char FILE_MAGIC[4] = { 'V', 'V', 'M', 'S' };
+
+		/*
+		* File layout: header, vertices (VvtModel::Vertex), indices (uint32_t).
+		* The checksum only covers the header with the checksum field set to zero. The payload is written through a
+		* temporary file and has to match the sizes in the header exactly, hashing it would cost about as much as parsing.
+		*/
+		struct MeshFileHeader {
+			char magic[4];
+			uint32_t version;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t reserved;
+			uint64_t sourceSize;
+			int64_t sourceWriteTime;
+			float minX, minY, minZ;
+			float maxX, maxY, maxZ;
+			uint64_t checksum;
+		};
+
+		static_assert(sizeof(MeshFileHeader) == 72, "The mesh file header must not contain padding!");
+		static_assert(sizeof(MeshFileHeader) % alignof(VvtModel::Vertex) == 0, "Mapped vertices have to be aligned!");
+
+		uint64_t checksum(MeshFileHeader header)
+		{
+			header.checksum = 0;
+			return hashBytes(&header, sizeof(header));
+		}
+
+		// Size and write time of the OBJ identify the version the cache was generated from
+		bool getSourceStamp(const std::string& objPath, uint64_t& size, int64_t& writeTime)
+		{
+			std::error_code error;
+			size = static_cast<uint64_t>(std::filesystem::file_size(objPath, error));
+			if (error)
+			{
+				return false;
+			}
+			auto time = std::filesystem::last_write_time(objPath, error);
+			writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+			return !error;
+		}
+	}
+
+	std::string VvtMeshCache::getCachePath(const std::string& objPath)
+	{
+		return objPath + ".vvtmesh";
+	}
+
+	bool VvtMeshCache::open(const std::string& objPath)
+	{
+		VVT_PROFILE_FUNCTION();
+		close();
+		mesh = VvtModel::MeshData{};
+
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+		if (!getSourceStamp(objPath, sourceSize, sourceWriteTime))
+		{
+			return false;
+		}
+
+		VvtMappedFile mapped{ getCachePath(objPath) };
+		if (!mapped.isOpen() || mapped.size() < sizeof(MeshFileHeader))
+		{
+			return false;
+		}
+
+		MeshFileHeader header;
+		std::memcpy(&header, mapped.data(), sizeof(header));
+		if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+			header.version != FILE_VERSION ||
+			header.vertexStride != sizeof(VvtModel::Vertex) ||
+			header.sourceSize != sourceSize ||
+			header.sourceWriteTime != sourceWriteTime ||
+			checksum(header) != header.checksum)
+		{
+			return false;
+		}
+
+		size_t vertexBytes = static_cast<size_t>(header.vertexCount) * sizeof(VvtModel::Vertex);
+		size_t indexBytes = static_cast<size_t>(header.indexCount) * sizeof(uint32_t);
+		if (mapped.size() != sizeof(MeshFileHeader) + vertexBytes + indexBytes)
+		{
+			return false;
+		}
+
+		file = std::move(mapped);
+		const unsigned char* payload = file.data() + sizeof(MeshFileHeader);
+		mesh.vertices = reinterpret_cast<const VvtModel::Vertex*>(payload);
+		mesh.vertexCount = header.vertexCount;
+		mesh.indices = reinterpret_cast<const uint32_t*>(payload + vertexBytes);
+		mesh.indexCount = header.indexCount;
+		mesh.minX = header.minX;
+		mesh.minY = header.minY;
+		mesh.minZ = header.minZ;
+		mesh.maxX = header.maxX;
+		mesh.maxY = header.maxY;
+		mesh.maxZ = header.maxZ;
+		return true;
+	}
+
+	bool VvtMeshCache::store(const std::string& objPath, const VvtModel::MeshData& mesh)
+	{
+		VVT_PROFILE_FUNCTION();
+		MeshFileHeader header{};
+		std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+		header.version = FILE_VERSION;
+		header.vertexStride = sizeof(VvtModel::Vertex);
+		header.vertexCount = mesh.vertexCount;
+		header.indexCount = mesh.indexCount;
+		if (!getSourceStamp(objPath, header.sourceSize, header.sourceWriteTime))
+		{
+			return false;
+		}
+		header.minX = mesh.minX;
+		header.minY = mesh.minY;
+		header.minZ = mesh.minZ;
+		header.maxX = mesh.maxX;
+		header.maxY = mesh.maxY;
+		header.maxZ = mesh.maxZ;
+		header.checksum = checksum(header);
+
+		// Write to a temporary file first, so a crash never leaves a truncated mesh behind
+		std::string filepath = getCachePath(objPath);
+		std::string tempFilepath = filepath + ".tmp";
+		{
+			std::ofstream file{ tempFilepath, std::ios::binary | std::ios::trunc };
+			if (!file.is_open())
+			{
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(mesh.vertices), static_cast<std::streamsize>(mesh.vertexCount * sizeof(VvtModel::Vertex)));
+			file.write(reinterpret_cast<const char*>(mesh.indices), static_cast<std::streamsize>(mesh.indexCount * sizeof(uint32_t)));
+			if (!file)
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilepath, filepath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempFilepath, error);
+			return false;
+		}
+		return true;
+	}
+}
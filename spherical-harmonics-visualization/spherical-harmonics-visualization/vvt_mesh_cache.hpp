@@ -0,0 +1,37 @@
+#pragma once
+#include "vvt_model.hpp"
+#include "vvt_mapped_file.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace vvt {
+
+	/*
+	* Preprocessed copy of an OBJ file, stored next to it with the extension ".vvtmesh": the deduplicated vertices,
+	* the indices and the bounds, in the in-memory layout of VvtModel. Cache files are memory-mapped and used in place,
+	* they are only accepted if the size and write time of the OBJ still match the ones they were generated from.
+	*/
+	class VvtMeshCache
+	{
+	public:
+		static constexpr uint32_t FILE_VERSION = 1;
+
+		static std::string getCachePath(const std::string& objPath);
+
+		// Returns false if there is no valid cache for the OBJ file
+		bool open(const std::string& objPath);
+		void close() { file.close(); }
+
+		// Points into the mapping, only valid while the cache is open
+		VvtModel::MeshData getMeshData() const { return mesh; }
+
+		// Failing to write is not an error, the OBJ will just be parsed again next time
+		static bool store(const std::string& objPath, const VvtModel::MeshData& mesh);
+
+	private:
+		VvtMappedFile file;
+		VvtModel::MeshData mesh{};
+	};
+}
@@ -1,75 +1,87 @@
 #include "vvt_model.hpp"
-#include "vvt_utils.hpp"
+#include "vvt_mesh_cache.hpp"
+#include "vvt_obj_loader.hpp"
 
 // libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
 // std
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <vector>
-#include <unordered_map>
 
-namespace std {
-    template<>
-    struct hash<vvt::VvtModel::Vertex> {
-        size_t operator()(vvt::VvtModel::Vertex const& vertex) const 
+namespace vvt {
+
+    namespace {
+
+        // Projects the unit normal onto the octahedron and folds the lower half over the diagonals, in [-1, 1]^2
+        glm::vec2 encodeOctahedral(glm::vec3 normal)
         {
-            size_t seed = 0;
-            vvt::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
+            float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+            if (length == 0.0f) {
+                return glm::vec2{ 0.0f };
+            }
+            normal /= length;
+
+            glm::vec2 encoded{ normal.x, normal.y };
+            if (normal.z < 0.0f) {
+                glm::vec2 sign{ normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f };
+                encoded = (1.0f - glm::abs(glm::vec2{ normal.y, normal.x })) * sign;
+            }
+            return encoded;
         }
-    };
-}
 
-namespace vvt {
+        template <typename T>
+        void write(unsigned char*& destination, const T& value)
+        {
+            std::memcpy(destination, &value, sizeof(T));
+            destination += sizeof(T);
+        }
+    }
 
-    VvtModel::VvtModel(VvtDevice& device, const VvtModel::Builder &builder) : vvtDevice{ device } {
-        og_vertex_data = builder.vertices;
-        old_vertex_data = builder.vertices;
-        new_vertex_data = builder.vertices;
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
-
-        minX = builder.minX;
-        maxX = builder.maxX;
-        minY = builder.minY;
-        maxY = builder.maxY;
-        minZ = builder.minZ;
-        maxZ = builder.maxZ;
+    VvtModel::VvtModel(VvtDevice& device, const VvtModel::Builder &builder, VertexLayout layout) : VvtModel{ device, builder.getMeshData(), layout } {}
+
+    VvtModel::VvtModel(VvtDevice& device, const MeshData& mesh, VertexLayout layout) : vvtDevice{ device }, vertexLayout{ layout } {
+        createVertexBuffers(mesh.vertices, mesh.vertexCount);
+        createIndexBuffers(mesh.indices, mesh.indexCount);
+
+        minX = mesh.minX;
+        maxX = mesh.maxX;
+        minY = mesh.minY;
+        maxY = mesh.maxY;
+        minZ = mesh.minZ;
+        maxZ = mesh.maxZ;
     }
 
     VvtModel::~VvtModel() {}
 
-    std::unique_ptr<VvtModel> VvtModel::createModelFromFile(VvtDevice& device, const std::string& filePath)
+    std::unique_ptr<VvtModel> VvtModel::createModelFromFile(VvtDevice& device, VvtThreadPool& threadPool, const std::string& filePath, VertexLayout layout)
     {
+        // The mapped arrays are copied straight into the staging ring, without parsing or deduplicating again
+        VvtMeshCache cache{};
+        if (cache.open(filePath)) {
+            MeshData mesh = cache.getMeshData();
+            std::cout << "Successfully loaded model with " << mesh.vertexCount << " vertices from " << VvtMeshCache::getCachePath(filePath) << "." << std::endl;
+            return std::make_unique<VvtModel>(device, mesh, layout);
+        }
+
         Builder builder{};
-        builder.loadModel(filePath);
+        builder.loadModel(filePath, threadPool);
         std::cout << "Successfully loaded model with " << builder.vertices.size() << " vertices." << std::endl;
         std::cout << "Min X: " << builder.minX << " Max X: " << builder.maxX << "Min Y: " << builder.minY << " Max Y: " << builder.maxY << "Min Z: " << builder.minZ << " Max Z: " << builder.maxZ << std::endl;
-        return std::make_unique<VvtModel>(device, builder);
+        if (!VvtMeshCache::store(filePath, builder.getMeshData())) {
+            std::cerr << "Failed to write the mesh cache file " << VvtMeshCache::getCachePath(filePath) << std::endl;
+        }
+        return std::make_unique<VvtModel>(device, builder, layout);
     }
 
-    void VvtModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
-        vertexCount = static_cast<uint32_t>(vertices.size());
+    void VvtModel::createVertexBuffers(const Vertex* vertices, uint32_t vertexCount) {
+        this->vertexCount = vertexCount;
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
-
-        VvtBuffer stagingBuffer{
-            vvtDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)vertices.data());
+        uint32_t vertexSize = vertexLayout.getStride();
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
 
         vertexBuffer = std::make_unique<VvtBuffer>(
             vvtDevice,
@@ -79,27 +91,24 @@ namespace vvt {
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
 
-        vvtDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        // Vertices and indices end up in the same upload batch, which is submitted with the next frame.
+        // Compact vertices are packed straight into the staging memory, full ones are copied as they are
+        VertexLayout layout = vertexLayout;
+        uploadTicket = vvtDevice.getUploadManager().uploadBuffer(
+            vertexBuffer->getBuffer(),
+            bufferSize,
+            [layout, vertices, vertexCount](void* mapped) { layout.encode(vertices, vertexCount, static_cast<unsigned char*>(mapped)); },
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
     }
 
-    void VvtModel::createIndexBuffers(const std::vector<uint32_t>& indices) {
-        indexCount = static_cast<uint32_t>(indices.size());
+    void VvtModel::createIndexBuffers(const uint32_t* indices, uint32_t indexCount) {
+        this->indexCount = indexCount;
         hasIndexBuffer = indexCount > 0;
         if (!hasIndexBuffer) return;
 
         VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
         uint32_t indexSize = sizeof(indices[0]);
-        
-        VvtBuffer stagingBuffer{
-            vvtDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)indices.data());
 
         indexBuffer = std::make_unique<VvtBuffer>(
             vvtDevice,
@@ -109,14 +118,15 @@ namespace vvt {
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
 
-        vvtDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        uploadTicket = vvtDevice.getUploadManager().uploadBuffer(
+            indexBuffer->getBuffer(), indices, bufferSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
     }
 
-    void VvtModel::draw(VkCommandBuffer commandBuffer) {
+    void VvtModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount) {
         if (hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
         } else {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
         }
     }
 
@@ -167,96 +177,96 @@ namespace vvt {
         return attributeDescriptions;
     }
 
-    void VvtModel::Builder::loadModel(const std::string& filePath)
+    uint32_t VvtModel::VertexLayout::getStride() const
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+        if (!compact) {
+            return sizeof(Vertex);
+        }
+        // Half positions are padded to four components, three component 16 bit formats are rarely supported for vertex input
+        uint32_t positionSize = halfPositions ? 4 * sizeof(uint16_t) : sizeof(glm::vec3);
+        uint32_t normalSize = 2 * sizeof(int16_t);
+        uint32_t uvSize = uvs ? 2 * sizeof(uint16_t) : 0;
+        return positionSize + normalSize + uvSize;
+    }
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str())) {
-            throw std::runtime_error(warn + err);
+    std::vector<VkVertexInputBindingDescription> VvtModel::VertexLayout::getBindingDescriptions() const
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions = Vertex::getBindingDescriptions();
+        bindingDescriptions[0].stride = getStride();
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> VvtModel::VertexLayout::getAttributeDescriptions() const
+    {
+        if (!compact) {
+            return Vertex::getAttributeDescriptions();
+        }
+
+        // Locations match the full layout, so shaders only differ in how they read the normal. There is no color
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(uvs ? 3 : 2);
+
+        // vertex position
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = halfPositions ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = 0;
+
+        // octahedral normal
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 2;
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[1].offset = halfPositions ? 4 * sizeof(uint16_t) : sizeof(glm::vec3);
+
+        // uv
+        if (uvs) {
+            attributeDescriptions[2].binding = 0;
+            attributeDescriptions[2].location = 3;
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[2].offset = attributeDescriptions[1].offset + 2 * sizeof(int16_t);
         }
+        return attributeDescriptions;
+    }
 
-        vertices.clear();
-        indices.clear();
-
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-
-        minX = std::numeric_limits<float>::max();
-        minY = std::numeric_limits<float>::max();
-        minZ = std::numeric_limits<float>::max();
-
-        maxX = std::numeric_limits<float>::min();
-        maxY = std::numeric_limits<float>::min();
-        maxZ = std::numeric_limits<float>::min();
-        
-        for (const auto& shape : shapes) {
-            for (const auto& index : shape.mesh.indices) {
-                Vertex vertex{};
-
-                // Reading vertex position
-                if (index.vertex_index >= 0) {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2], 
-                    };
-
-                    // Object boundaries
-                    if (attrib.vertices[3 * index.vertex_index + 0] < minX) {
-                        minX = attrib.vertices[3 * index.vertex_index + 0];
-                    }
-                    if (attrib.vertices[3 * index.vertex_index + 0] > maxX) {
-                        maxX = attrib.vertices[3 * index.vertex_index + 0];
-                    }
-                    if (attrib.vertices[3 * index.vertex_index + 1] < minY) {
-                        minY = attrib.vertices[3 * index.vertex_index + 1];
-                    }
-                    if (attrib.vertices[3 * index.vertex_index + 1] > maxY) {
-                        maxY = attrib.vertices[3 * index.vertex_index + 1];
-                    }
-                    if (attrib.vertices[3 * index.vertex_index + 2] < minZ) {
-                        minZ = attrib.vertices[3 * index.vertex_index + 2];
-                    }
-                    if (attrib.vertices[3 * index.vertex_index + 2] > maxZ) {
-                        maxZ = attrib.vertices[3 * index.vertex_index + 2];
-                    }
-
-                    // Vertex color expansion (not supported in .OBJ by default, but tinyobjloader supports it)
-                    // The vertex RGB color appears in the .OBJ file right after the vertex position.
-                    vertex.color = {
-                            attrib.colors[3 * index.vertex_index + 0],
-                            attrib.colors[3 * index.vertex_index + 1],
-                            attrib.colors[3 * index.vertex_index + 2],
-                    };
-                }
-
-                // Reading normal
-                if (index.normal_index >= 0) {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2],
-                    };
-                }
-
-                // Reading UV coords
-                if (index.texcoord_index >= 0) {
-                    vertex.uv = {
-                        attrib.texcoords[3 * index.texcoord_index + 0],
-                        attrib.texcoords[3 * index.texcoord_index + 1],
-                    };
-                }
-
-                // We avoid vertex duplication by using an index buffer 
-                // (unordered map checks whether a vertex has already been referenced before)
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-               }
-                indices.push_back(uniqueVertices[vertex]);
+    void VvtModel::VertexLayout::encode(const Vertex* vertices, uint32_t vertexCount, unsigned char* destination) const
+    {
+        if (!compact) {
+            std::memcpy(destination, vertices, static_cast<size_t>(vertexCount) * sizeof(Vertex));
+            return;
+        }
+
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            const Vertex& vertex = vertices[i];
+            if (halfPositions) {
+                write(destination, glm::packHalf4x16(glm::vec4{ vertex.position, 1.0f }));
+            } else {
+                write(destination, vertex.position);
+            }
+            write(destination, glm::packSnorm2x16(encodeOctahedral(vertex.normal)));
+            if (uvs) {
+                write(destination, glm::packHalf2x16(vertex.uv));
             }
         }
     }
-}
\ No newline at end of file
+
+    VvtModel::MeshData VvtModel::Builder::getMeshData() const
+    {
+        MeshData mesh{};
+        mesh.vertices = vertices.data();
+        mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+        mesh.indices = indices.data();
+        mesh.indexCount = static_cast<uint32_t>(indices.size());
+        mesh.minX = minX;
+        mesh.maxX = maxX;
+        mesh.minY = minY;
+        mesh.maxY = maxY;
+        mesh.minZ = minZ;
+        mesh.maxZ = maxZ;
+        return mesh;
+    }
+
+    void VvtModel::Builder::loadModel(const std::string& filePath, VvtThreadPool& threadPool)
+    {
+        VvtObjLoader loader{ threadPool };
+        loader.load(filePath, *this);
+    }
+}
@@ -13,6 +13,8 @@
 #include <vector>
 
 namespace vvt {
+	class VvtThreadPool;
+
 	class VvtModel
 	{
 	public:
@@ -30,6 +32,45 @@ namespace vvt {
 			}
 		};
 
+		/*
+		* Layout of the vertex buffer on the GPU. The full layout is Vertex itself (44 bytes). Compact layouts drop the
+		* vertex colors, store the normal octahedral encoded as snorm16x2 and the position as float3 or half4, and only
+		* keep the uvs as half2 if asked to: 12 to 20 bytes. Pipelines take their vertex input from the layout of the
+		* models they draw, and shaders for compact layouts have to decode the normal (see point_shader.vert).
+		*/
+		struct VertexLayout {
+			bool compact = false;
+			bool halfPositions = false;	// Compact layouts only
+			bool uvs = true;			// Always part of the full layout
+
+			static VertexLayout full() { return {}; }
+			static VertexLayout compactLayout(bool halfPositions, bool uvs) { return { true, halfPositions, uvs }; }
+
+			uint32_t getStride() const;
+			std::vector<VkVertexInputBindingDescription> getBindingDescriptions() const;
+			std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() const;
+			// Writes vertexCount vertices of this layout to destination, which must hold vertexCount * getStride() bytes
+			void encode(const Vertex* vertices, uint32_t vertexCount, unsigned char* destination) const;
+
+			bool operator==(const VertexLayout& other) const {
+				return compact == other.compact && (!compact || (halfPositions == other.halfPositions && uvs == other.uvs));
+			}
+		};
+
+		// Vertex and index arrays of a mesh with its bounds, owned by a Builder or a mapped mesh cache
+		struct MeshData {
+			const Vertex* vertices = nullptr;
+			uint32_t vertexCount = 0;
+			const uint32_t* indices = nullptr;
+			uint32_t indexCount = 0;
+			float minX;
+			float maxX;
+			float minY;
+			float maxY;
+			float minZ;
+			float maxZ;
+		};
+
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
@@ -40,10 +81,13 @@ namespace vvt {
 			float minZ;
 			float maxZ;
 
-			void loadModel(const std::string& filePath);
+			void loadModel(const std::string& filePath, VvtThreadPool& threadPool);
+			MeshData getMeshData() const;
 		};
 
-		VvtModel(VvtDevice &device, const VvtModel::Builder &builder);
+		VvtModel(VvtDevice &device, const VvtModel::Builder &builder, VertexLayout layout = VertexLayout::full());
+		// The arrays are copied into staging memory right away and don't have to outlive the constructor
+		VvtModel(VvtDevice &device, const MeshData &mesh, VertexLayout layout = VertexLayout::full());
 		~VvtModel();
 
 		VvtModel(const VvtModel&) = delete;
@@ -55,16 +99,19 @@ namespace vvt {
 		float maximumY() { return maxY; };
 		float minimumZ() { return minZ; };
 		float maximumZ() { return maxZ; };
-		std::vector<Vertex>& getVertices() { return old_vertex_data; };
+		// The buffers can be drawn once this ticket completed, frames submitted after the upload batch see them anyway
+		VvtUploadTicket getUploadTicket() const { return uploadTicket; };
+		VertexLayout getVertexLayout() const { return vertexLayout; };
 
-		static std::unique_ptr<VvtModel> createModelFromFile(VvtDevice& device, const std::string& filePath);
+		// Loads the mesh cache next to the OBJ file if it is up to date, otherwise parses the OBJ and writes the cache
+		static std::unique_ptr<VvtModel> createModelFromFile(VvtDevice& device, VvtThreadPool& threadPool, const std::string& filePath, VertexLayout layout = VertexLayout::full());
 
 		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1);
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex> &vertices);
-		void createIndexBuffers(const std::vector<uint32_t> &indices);
+		void createVertexBuffers(const Vertex* vertices, uint32_t vertexCount);
+		void createIndexBuffers(const uint32_t* indices, uint32_t indexCount);
 
 		float minX;
 		float maxX;
@@ -75,10 +122,7 @@ namespace vvt {
 
 		VvtDevice& vvtDevice;
 
-		std::vector<Vertex> og_vertex_data;
-		std::vector<Vertex> old_vertex_data;
-		std::vector<Vertex> new_vertex_data;
-
+		VertexLayout vertexLayout;
 		std::unique_ptr<VvtBuffer> vertexBuffer;
 		uint32_t vertexCount;
 
@@ -86,5 +130,7 @@ namespace vvt {
 		std::unique_ptr<VvtBuffer> indexBuffer;
 
 		uint32_t indexCount;
+
+		VvtUploadTicket uploadTicket = 0;
 	};
 }
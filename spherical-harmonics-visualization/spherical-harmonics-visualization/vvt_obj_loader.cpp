@@ -0,0 +1,605 @@
+#include "vvt_obj_loader.hpp"
+#include "vvt_mapped_file.hpp"
+#include "vvt_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace vvt {
+
+	namespace {
+
+		// Smaller files are parsed in one piece, splitting them costs more than it saves
+		constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+		constexpr size_t CHUNKS_PER_THREAD = 4;
+		constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+		// Zero based attribute indices of a face corner, -1 for attributes the corner doesn't reference
+		struct Corner {
+			int32_t position;
+			int32_t texcoord;
+			int32_t normal;
+
+			bool operator==(const Corner& other) const
+			{
+				return position == other.position && texcoord == other.texcoord && normal == other.normal;
+			}
+		};
+
+		// Face corner while parsing, the bits of the mask mark components that still have to be offset by the chunk start
+		struct FaceCorner {
+			Corner corner;
+			uint32_t relativeMask;
+		};
+
+		struct ParsedChunk {
+			std::vector<float> positions;
+			std::vector<float> colors;
+			std::vector<float> normals;
+			std::vector<float> texcoords;
+			std::vector<Corner> corners;
+			// Components that negative OBJ indices made relative to the first attribute of the chunk, as corner * 3 + component
+			std::vector<uint32_t> relativeComponents;
+
+			// Deduplicated corners in the order of their first use and the index of every corner into them
+			std::vector<Corner> uniqueCorners;
+			std::vector<uint64_t> uniqueHashes;
+			std::vector<uint32_t> localIndices;
+		};
+
+		// Prefix sums over the chunks, the entry of a chunk is the number of elements in all chunks before it
+		struct ChunkOffsets {
+			size_t position = 0;
+			size_t texcoord = 0;
+			size_t normal = 0;
+			size_t corner = 0;
+			size_t unique = 0;
+			size_t vertex = 0;
+		};
+
+		struct Bounds {
+			float min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			float max[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+		};
+
+		uint64_t hashCorner(const Corner& corner)
+		{
+			uint64_t hash = static_cast<uint32_t>(corner.position) * 0x9e3779b97f4a7c15ull;
+			hash ^= static_cast<uint32_t>(corner.texcoord) * 0xc2b2ae3d27d4eb4full;
+			hash ^= static_cast<uint32_t>(corner.normal) * 0x165667b19e3779f9ull;
+			hash ^= hash >> 29;
+			hash *= 0xbf58476d1ce4e5b9ull;
+			return hash ^ (hash >> 32);
+		}
+
+		/*
+		* Linear probing table of corner ids. The corners live in an array next to the table, so a slot is only
+		* four bytes and probes compare the keys through that array.
+		*/
+		class CornerTable
+		{
+		public:
+			explicit CornerTable(size_t expectedCount)
+			{
+				size_t capacity = 16;
+				while (capacity < expectedCount * 2)
+				{
+					capacity *= 2;
+				}
+				slots.assign(capacity, EMPTY_SLOT);
+				mask = capacity - 1;
+			}
+
+			// Id of the first inserted corner that equals corners[id], inserts id if there is none
+			uint32_t findOrInsert(const Corner* corners, uint32_t id, uint64_t hash)
+			{
+				for (size_t slot = static_cast<size_t>(hash) & mask;; slot = (slot + 1) & mask)
+				{
+					if (slots[slot] == EMPTY_SLOT)
+					{
+						slots[slot] = id;
+						return id;
+					}
+					if (corners[slots[slot]] == corners[id])
+					{
+						return slots[slot];
+					}
+				}
+			}
+
+		private:
+			std::vector<uint32_t> slots;
+			size_t mask;
+		};
+
+		// Runs task(i) for every i in [0, count) on the pool and waits for all of them, even if one throws
+		template <typename F>
+		void parallelFor(VvtThreadPool& threadPool, size_t count, const F& task)
+		{
+			if (count == 1)
+			{
+				task(0);
+				return;
+			}
+
+			std::vector<std::future<void>> jobs;
+			jobs.reserve(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				jobs.push_back(threadPool.submit([&task, i]() { task(i); }));
+			}
+
+			std::exception_ptr error;
+			for (auto& job : jobs)
+			{
+				try
+				{
+					job.get();
+				}
+				catch (...)
+				{
+					if (!error)
+					{
+						error = std::current_exception();
+					}
+				}
+			}
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
+
+		bool isSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		const char* skipSpaces(const char* p, const char* end)
+		{
+			while (p < end && isSpace(*p))
+			{
+				p++;
+			}
+			return p;
+		}
+
+		bool parseFloat(const char*& p, const char* end, float& value)
+		{
+			p = skipSpaces(p, end);
+			if (p < end && *p == '+')
+			{
+				p++;
+			}
+			std::from_chars_result result = std::from_chars(p, end, value);
+			if (result.ptr == p)
+			{
+				return false;
+			}
+			// Denormals and overflowing values are left unchanged by from_chars
+			if (result.ec == std::errc::result_out_of_range)
+			{
+				value = 0.0f;
+			}
+			p = result.ptr;
+			return true;
+		}
+
+		bool parseIndex(const char*& p, const char* end, int32_t& value)
+		{
+			std::from_chars_result result = std::from_chars(p, end, value);
+			if (result.ec != std::errc{} || value == 0)
+			{
+				return false;
+			}
+			p = result.ptr;
+			return true;
+		}
+
+		// OBJ indices start at one, negative ones count back from the latest attribute of their kind
+		int32_t toChunkIndex(int32_t objIndex, size_t chunkCount, uint32_t component, uint32_t& relativeMask)
+		{
+			if (objIndex > 0)
+			{
+				return objIndex - 1;
+			}
+			relativeMask |= 1u << component;
+			return static_cast<int32_t>(chunkCount) + objIndex;
+		}
+
+		int32_t& getComponent(Corner& corner, uint32_t component)
+		{
+			switch (component)
+			{
+			case 0:
+				return corner.position;
+			case 1:
+				return corner.texcoord;
+			default:
+				return corner.normal;
+			}
+		}
+
+		void appendCorner(ParsedChunk& chunk, const FaceCorner& faceCorner)
+		{
+			uint32_t cornerIndex = static_cast<uint32_t>(chunk.corners.size());
+			for (uint32_t component = 0; component < 3; component++)
+			{
+				if (faceCorner.relativeMask & (1u << component))
+				{
+					chunk.relativeComponents.push_back(cornerIndex * 3 + component);
+				}
+			}
+			chunk.corners.push_back(faceCorner.corner);
+		}
+
+		// Faces are triangulated as fans, like tinyobjloader does. Parsing stops at the first malformed corner
+		void parseFace(const char* p, const char* end, ParsedChunk& chunk, std::vector<FaceCorner>& face)
+		{
+			face.clear();
+			while ((p = skipSpaces(p, end)) < end)
+			{
+				FaceCorner faceCorner{ { -1, -1, -1 }, 0 };
+				int32_t index;
+				if (!parseIndex(p, end, index))
+				{
+					break;
+				}
+				faceCorner.corner.position = toChunkIndex(index, chunk.positions.size() / 3, 0, faceCorner.relativeMask);
+
+				if (p < end && *p == '/')
+				{
+					p++;
+					if (p < end && *p != '/' && !isSpace(*p))
+					{
+						if (!parseIndex(p, end, index))
+						{
+							break;
+						}
+						faceCorner.corner.texcoord = toChunkIndex(index, chunk.texcoords.size() / 2, 1, faceCorner.relativeMask);
+					}
+					if (p < end && *p == '/')
+					{
+						p++;
+						if (!parseIndex(p, end, index))
+						{
+							break;
+						}
+						faceCorner.corner.normal = toChunkIndex(index, chunk.normals.size() / 3, 2, faceCorner.relativeMask);
+					}
+				}
+				face.push_back(faceCorner);
+			}
+
+			for (size_t i = 2; i < face.size(); i++)
+			{
+				appendCorner(chunk, face[0]);
+				appendCorner(chunk, face[i - 1]);
+				appendCorner(chunk, face[i]);
+			}
+		}
+
+		void parseChunk(const char* p, const char* end, ParsedChunk& chunk)
+		{
+			std::vector<FaceCorner> face;
+			float values[6];
+			while (p < end)
+			{
+				const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+				if (lineEnd == nullptr)
+				{
+					lineEnd = end;
+				}
+				p = skipSpaces(p, lineEnd);
+
+				if (lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1]))
+				{
+					// Vertex colors follow the position, like tinyobjloader reads them. Vertices without one are white
+					const char* q = p + 1;
+					int count = 0;
+					while (count < 6 && parseFloat(q, lineEnd, values[count]))
+					{
+						count++;
+					}
+					for (int i = 0; i < 3; i++)
+					{
+						chunk.positions.push_back(i < count ? values[i] : 0.0f);
+						chunk.colors.push_back(count >= 6 ? values[3 + i] : 1.0f);
+					}
+				}
+				else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+				{
+					const char* q = p + 2;
+					int count = 0;
+					while (count < 2 && parseFloat(q, lineEnd, values[count]))
+					{
+						count++;
+					}
+					chunk.texcoords.push_back(count > 0 ? values[0] : 0.0f);
+					chunk.texcoords.push_back(count > 1 ? values[1] : 0.0f);
+				}
+				else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+				{
+					const char* q = p + 2;
+					int count = 0;
+					while (count < 3 && parseFloat(q, lineEnd, values[count]))
+					{
+						count++;
+					}
+					for (int i = 0; i < 3; i++)
+					{
+						chunk.normals.push_back(i < count ? values[i] : 0.0f);
+					}
+				}
+				else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1]))
+				{
+					parseFace(p + 1, lineEnd, chunk, face);
+				}
+
+				p = lineEnd + (lineEnd < end ? 1 : 0);
+			}
+		}
+
+		// Turns the corners into global attribute indices and deduplicates them within the chunk
+		void resolveChunk(ParsedChunk& chunk, const ChunkOffsets& offsets, const ChunkOffsets& totals)
+		{
+			const size_t chunkStarts[3] = { offsets.position, offsets.texcoord, offsets.normal };
+			for (uint32_t component : chunk.relativeComponents)
+			{
+				int32_t& index = getComponent(chunk.corners[component / 3], component % 3);
+				index += static_cast<int32_t>(chunkStarts[component % 3]);
+				if (index < 0)
+				{
+					throw std::runtime_error("OBJ face references an attribute before the first one!");
+				}
+			}
+
+			CornerTable table{ chunk.corners.size() };
+			chunk.localIndices.resize(chunk.corners.size());
+			for (size_t i = 0; i < chunk.corners.size(); i++)
+			{
+				const Corner& corner = chunk.corners[i];
+				if (static_cast<size_t>(corner.position) >= totals.position ||
+					(corner.texcoord >= 0 && static_cast<size_t>(corner.texcoord) >= totals.texcoord) ||
+					(corner.normal >= 0 && static_cast<size_t>(corner.normal) >= totals.normal))
+				{
+					throw std::runtime_error("OBJ face references an attribute that doesn't exist!");
+				}
+
+				// The candidate is appended first, so the table can compare it through the array
+				uint64_t hash = hashCorner(corner);
+				uint32_t candidate = static_cast<uint32_t>(chunk.uniqueCorners.size());
+				chunk.uniqueCorners.push_back(corner);
+				uint32_t id = table.findOrInsert(chunk.uniqueCorners.data(), candidate, hash);
+				if (id == candidate)
+				{
+					chunk.uniqueHashes.push_back(hash);
+				}
+				else
+				{
+					chunk.uniqueCorners.pop_back();
+				}
+				chunk.localIndices[i] = id;
+			}
+
+			chunk.corners = {};
+			chunk.relativeComponents = {};
+		}
+
+		template <typename T>
+		void moveInto(std::vector<T>& source, std::vector<T>& destination, size_t offset)
+		{
+			std::copy(source.begin(), source.end(), destination.begin() + offset);
+			source = {};
+		}
+	}
+
+	VvtObjLoader::VvtObjLoader(VvtThreadPool& threadPool) : threadPool{ threadPool }
+	{
+	}
+
+	void VvtObjLoader::load(const std::string& filePath, VvtModel::Builder& builder) const
+	{
+		VVT_PROFILE_FUNCTION();
+		assert(threadPool.getCurrentWorkerIndex() < 0 && "OBJ files cannot be loaded from a worker of the pool they are loaded on!");
+
+		VvtMappedFile file{ filePath };
+		if (!file.isOpen())
+		{
+			throw std::runtime_error("failed to open OBJ file: " + filePath);
+		}
+		const char* text = reinterpret_cast<const char*>(file.data());
+		size_t size = file.size();
+
+		// Every chunk but the first starts at the beginning of a line
+		size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_BYTES, 1, threadPool.getThreadCount() * CHUNKS_PER_THREAD);
+		std::vector<size_t> boundaries(chunkCount + 1, size);
+		boundaries[0] = 0;
+		for (size_t chunk = 1; chunk < chunkCount; chunk++)
+		{
+			size_t start = std::max(size / chunkCount * chunk, boundaries[chunk - 1]);
+			const void* newline = std::memchr(text + start, '\n', size - start);
+			boundaries[chunk] = newline != nullptr ? static_cast<size_t>(static_cast<const char*>(newline) - text) + 1 : size;
+		}
+
+		std::vector<ParsedChunk> chunks(chunkCount);
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			parseChunk(text + boundaries[chunk], text + boundaries[chunk + 1], chunks[chunk]);
+		});
+
+		std::vector<ChunkOffsets> offsets(chunkCount + 1);
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			offsets[chunk + 1].position = offsets[chunk].position + chunks[chunk].positions.size() / 3;
+			offsets[chunk + 1].texcoord = offsets[chunk].texcoord + chunks[chunk].texcoords.size() / 2;
+			offsets[chunk + 1].normal = offsets[chunk].normal + chunks[chunk].normals.size() / 3;
+			offsets[chunk + 1].corner = offsets[chunk].corner + chunks[chunk].corners.size();
+		}
+		ChunkOffsets totals = offsets[chunkCount];
+		if (std::max({ totals.position, totals.texcoord, totals.normal }) > static_cast<size_t>(std::numeric_limits<int32_t>::max()) ||
+			totals.corner >= EMPTY_SLOT)
+		{
+			throw std::runtime_error("OBJ file is too large: " + filePath);
+		}
+
+		// Attributes are concatenated, so the vertices can be built from global indices
+		std::vector<float> positions(totals.position * 3);
+		std::vector<float> colors(totals.position * 3);
+		std::vector<float> texcoords(totals.texcoord * 2);
+		std::vector<float> normals(totals.normal * 3);
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			ParsedChunk& parsed = chunks[chunk];
+			moveInto(parsed.positions, positions, offsets[chunk].position * 3);
+			moveInto(parsed.colors, colors, offsets[chunk].position * 3);
+			moveInto(parsed.texcoords, texcoords, offsets[chunk].texcoord * 2);
+			moveInto(parsed.normals, normals, offsets[chunk].normal * 3);
+			resolveChunk(parsed, offsets[chunk], totals);
+		});
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			offsets[chunk + 1].unique = offsets[chunk].unique + chunks[chunk].uniqueCorners.size();
+		}
+		size_t uniqueCount = offsets[chunkCount].unique;
+
+		std::vector<Corner> uniqueCorners(uniqueCount);
+		std::vector<uint64_t> uniqueHashes(uniqueCount);
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			moveInto(chunks[chunk].uniqueCorners, uniqueCorners, offsets[chunk].unique);
+			moveInto(chunks[chunk].uniqueHashes, uniqueHashes, offsets[chunk].unique);
+		});
+
+		/*
+		* Merge: every shard owns the corners whose hash maps to it and scans them in file order, so the owner of a
+		* corner is its first use in the file. Shards use the upper hash bits, the tables index with the lower ones.
+		*/
+		std::vector<uint32_t> owners(uniqueCount);
+		if (chunkCount == 1)
+		{
+			for (size_t u = 0; u < uniqueCount; u++)
+			{
+				owners[u] = static_cast<uint32_t>(u);
+			}
+		}
+		else
+		{
+			VVT_PROFILE_SCOPE("VvtObjLoader merge");
+			size_t shardCount = threadPool.getThreadCount();
+			parallelFor(threadPool, shardCount, [&](size_t shard)
+			{
+				size_t shardSize = 0;
+				for (size_t u = 0; u < uniqueCount; u++)
+				{
+					shardSize += (uniqueHashes[u] >> 40) % shardCount == shard;
+				}
+
+				CornerTable table{ shardSize };
+				for (size_t u = 0; u < uniqueCount; u++)
+				{
+					if ((uniqueHashes[u] >> 40) % shardCount == shard)
+					{
+						owners[u] = table.findOrInsert(uniqueCorners.data(), static_cast<uint32_t>(u), uniqueHashes[u]);
+					}
+				}
+			});
+		}
+
+		// Owners become vertices, numbered in file order
+		std::vector<uint32_t> vertexIds(uniqueCount);
+		std::vector<size_t> ownerCounts(chunkCount, 0);
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			for (size_t u = offsets[chunk].unique; u < offsets[chunk + 1].unique; u++)
+			{
+				ownerCounts[chunk] += owners[u] == u;
+			}
+		});
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			offsets[chunk + 1].vertex = offsets[chunk].vertex + ownerCounts[chunk];
+		}
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			uint32_t vertexId = static_cast<uint32_t>(offsets[chunk].vertex);
+			for (size_t u = offsets[chunk].unique; u < offsets[chunk + 1].unique; u++)
+			{
+				if (owners[u] == u)
+				{
+					vertexIds[u] = vertexId++;
+				}
+			}
+		});
+
+		// Owners always come first, so every duplicate can look up the id of its owner now
+		builder.vertices.resize(offsets[chunkCount].vertex);
+		builder.indices.resize(totals.corner);
+		std::vector<Bounds> chunkBounds(chunkCount);
+		parallelFor(threadPool, chunkCount, [&](size_t chunk)
+		{
+			Bounds& bounds = chunkBounds[chunk];
+			for (size_t u = offsets[chunk].unique; u < offsets[chunk + 1].unique; u++)
+			{
+				if (owners[u] != u)
+				{
+					vertexIds[u] = vertexIds[owners[u]];
+					continue;
+				}
+
+				const Corner& corner = uniqueCorners[u];
+				VvtModel::Vertex& vertex = builder.vertices[vertexIds[u]];
+				size_t position = static_cast<size_t>(corner.position) * 3;
+				vertex.position = { positions[position + 0], positions[position + 1], positions[position + 2] };
+				vertex.color = { colors[position + 0], colors[position + 1], colors[position + 2] };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					bounds.min[axis] = std::min(bounds.min[axis], positions[position + axis]);
+					bounds.max[axis] = std::max(bounds.max[axis], positions[position + axis]);
+				}
+				if (corner.normal >= 0)
+				{
+					size_t normal = static_cast<size_t>(corner.normal) * 3;
+					vertex.normal = { normals[normal + 0], normals[normal + 1], normals[normal + 2] };
+				}
+				if (corner.texcoord >= 0)
+				{
+					size_t texcoord = static_cast<size_t>(corner.texcoord) * 2;
+					vertex.uv = { texcoords[texcoord + 0], texcoords[texcoord + 1] };
+				}
+			}
+
+			const std::vector<uint32_t>& localIndices = chunks[chunk].localIndices;
+			uint32_t* indices = builder.indices.data() + offsets[chunk].corner;
+			for (size_t i = 0; i < localIndices.size(); i++)
+			{
+				indices[i] = vertexIds[offsets[chunk].unique + localIndices[i]];
+			}
+		});
+
+		Bounds bounds{};
+		for (const Bounds& chunk : chunkBounds)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				bounds.min[axis] = std::min(bounds.min[axis], chunk.min[axis]);
+				bounds.max[axis] = std::max(bounds.max[axis], chunk.max[axis]);
+			}
+		}
+		builder.minX = bounds.min[0];
+		builder.minY = bounds.min[1];
+		builder.minZ = bounds.min[2];
+		builder.maxX = bounds.max[0];
+		builder.maxY = bounds.max[1];
+		builder.maxZ = bounds.max[2];
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "vvt_model.hpp"
+#include "vvt_thread_pool.hpp"
+
+// std
+#include <string>
+
+namespace vvt {
+
+	/*
+	* Parallel loader for the subset of Wavefront OBJ the visualizations use: positions with optional vertex colors,
+	* normals, texture coordinates and polygonal faces, which are triangulated as fans. Everything else is skipped.
+	* The mapped file is split into chunks at line boundaries that are parsed on the thread pool. Corners are
+	* deduplicated by their (position, texcoord, normal) index triplet, first within each chunk and then across chunks
+	* in hash partitioned shards, so the vertex order is the order of first use in the file, like a sequential load.
+	*/
+	class VvtObjLoader
+	{
+	public:
+		explicit VvtObjLoader(VvtThreadPool& threadPool);
+
+		// Replaces the vertices, indices and bounds of the builder. Blocks on the pool, so don't call it from a worker
+		void load(const std::string& filePath, VvtModel::Builder& builder) const;
+
+	private:
+		VvtThreadPool& threadPool;
+	};
+}
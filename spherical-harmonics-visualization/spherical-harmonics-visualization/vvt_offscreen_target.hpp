@@ -0,0 +1,65 @@
+#pragma once
+
+#include "vvt_device.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <vector>
+
+namespace vvt {
+
+// Stand-in for VvtSwapChain when rendering headless: one color and depth image per frame in flight,
+// nothing is presented. Color images end up in TRANSFER_SRC_OPTIMAL, so they can be read back.
+class VvtOffscreenTarget {
+ public:
+  VvtOffscreenTarget(VvtDevice &deviceRef, VkExtent2D extent);
+  ~VvtOffscreenTarget();
+
+  VvtOffscreenTarget(const VvtOffscreenTarget &) = delete;
+  VvtOffscreenTarget &operator=(const VvtOffscreenTarget &) = delete;
+
+  VkFramebuffer getFrameBuffer(int index) { return framebuffers[index]; }
+  VkRenderPass getRenderPass() { return renderPass; }
+  VkImage getColorImage(int index) { return colorImages[index]; }
+  size_t imageCount() { return colorImages.size(); }
+  VkFormat getColorFormat() { return colorFormat; }
+  VkExtent2D getExtent() { return extent; }
+
+  float extentAspectRatio() {
+    return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+  }
+
+  // Same contract as VvtSwapChain: waits until the image of the next frame is no longer in use
+  VkResult acquireNextImage(uint32_t *imageIndex);
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+
+ private:
+  void createImages();
+  void createRenderPass();
+  void createFramebuffers();
+  void createSyncObjects();
+
+  VkFormat findDepthFormat();
+
+  VvtDevice &device;
+  VkExtent2D extent;
+  VkFormat colorFormat;
+  VkFormat depthFormat;
+
+  VkRenderPass renderPass;
+  std::vector<VkFramebuffer> framebuffers;
+
+  std::vector<VkImage> colorImages;
+  std::vector<VvtAllocation> colorImageMemorys;
+  std::vector<VkImageView> colorImageViews;
+  std::vector<VkImage> depthImages;
+  std::vector<VvtAllocation> depthImageMemorys;
+  std::vector<VkImageView> depthImageViews;
+
+  std::vector<VkFence> inFlightFences;
+  size_t currentFrame = 0;
+};
+
+}  // namespace vvt
@@ -2,8 +2,7 @@
 #include "vvt_model.hpp"
 
 // std 
-
-#include <fstream>
+#include <chrono>
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
@@ -23,31 +22,16 @@ namespace vvt {
 
 	}
 
-	std::vector<char> VvtPipeline::readFile(const std::string& filePath)
-	{
-		std::ifstream file(filePath, std::ios::ate | std::ios::binary);
-
-		if (!file.is_open())
-		{
-			throw std::runtime_error("Failed to open file: " + filePath);
-		}
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		
-		file.close();
-		return buffer;
-	}
-
 	void VvtPipeline::createGraphicsPipeline(const std::string vertFilePath, const std::string fragFilePath, const PipelineConfigInfo& configInfo)
 	{
 		assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: No pipeline layout was provided in configInfo.");
 		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: No render pass was provided in configInfo.");
 
-		auto vertCode = readFile(vertFilePath);
-		auto fragCode = readFile(fragFilePath);
+		// Shader modules are part of what the pipeline cache can't skip, so they are timed as well
+		auto startTime = std::chrono::high_resolution_clock::now();
+		VvtPipelineCache& pipelineCache = vvtDevice.getPipelineCache();
+		const std::vector<char>& vertCode = pipelineCache.getShaderCode(vertFilePath);
+		const std::vector<char>& fragCode = pipelineCache.getShaderCode(fragFilePath);
 
 		createShaderModule(vertCode, &vertShaderModule);
 		createShaderModule(fragCode, &fragShaderModule);
@@ -59,17 +43,17 @@ namespace vvt {
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = configInfo.vertexSpecializationInfo;
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 		shaderStages[1].module = fragShaderModule;
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = configInfo.fragmentSpecializationInfo;
 
-		auto bindingDescriptions = VvtModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = VvtModel::Vertex::getAttributeDescriptions();
+		auto& bindingDescriptions = configInfo.bindingDescriptions;
+		auto& attributeDescriptions = configInfo.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -101,13 +85,18 @@ namespace vvt {
 
 		if (vkCreateGraphicsPipelines(
 			vvtDevice.device(),
-			VK_NULL_HANDLE,
+			pipelineCache.getCache(),
 			1,
 			&pipelineInfo,
 			nullptr,
 			&graphicsPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline");
 		}
+
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		pipelineCache.recordPipelineCreation(milliseconds);
+		std::cout << "Created pipeline " << vertFilePath << " + " << fragFilePath << " in " << milliseconds << " ms ("
+			<< (pipelineCache.isWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
 	}
 
 	void VvtPipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
@@ -198,6 +187,9 @@ namespace vvt {
 		configInfo.dynamicStateInfo.dynamicStateCount =
 			static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		configInfo.bindingDescriptions = VvtModel::Vertex::getBindingDescriptions();
+		configInfo.attributeDescriptions = VvtModel::Vertex::getAttributeDescriptions();
 	}
 
 	void VvtPipeline::skyboxPipelineConfigInfo(PipelineConfigInfo& configInfo)
@@ -270,6 +262,9 @@ namespace vvt {
 		configInfo.dynamicStateInfo.dynamicStateCount =
 			static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		configInfo.bindingDescriptions = VvtModel::Vertex::getBindingDescriptions();
+		configInfo.attributeDescriptions = VvtModel::Vertex::getAttributeDescriptions();
 	}
 
 }
\ No newline at end of file
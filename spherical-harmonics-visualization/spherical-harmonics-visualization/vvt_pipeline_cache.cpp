@@ -0,0 +1,196 @@
+#include "vvt_pipeline_cache.hpp"
+#include "vvt_utils.hpp"
+#include "vvt_profiler.hpp"
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace vvt {
+
+namespace {
+
+constexpr char FILE_MAGIC[4] = {'V', 'V', 'P', 'C'};
+constexpr uint32_t FILE_VERSION = 1;
+
+/*
+ * File layout: header, data of vkGetPipelineCacheData. The driver checks its own header of the data as well, but
+ * not the driver version, and drivers have crashed on caches of other versions before.
+ */
+struct PipelineCacheFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint32_t driverVersion;
+  uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+  uint32_t reserved;
+  uint64_t dataSize;
+  uint64_t checksum;
+};
+
+static_assert(sizeof(PipelineCacheFileHeader) == 56, "The pipeline cache file header must not contain padding!");
+
+// Covers the header with the checksum field set to zero and the data
+uint64_t checksum(PipelineCacheFileHeader header, const std::vector<char> &data) {
+  header.checksum = 0;
+  uint64_t hash = hashBytes(&header, sizeof(header));
+  return hashBytes(data.data(), data.size(), hash);
+}
+
+PipelineCacheFileHeader createHeader(const VkPhysicalDeviceProperties &properties) {
+  PipelineCacheFileHeader header{};
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = FILE_VERSION;
+  header.vendorID = properties.vendorID;
+  header.deviceID = properties.deviceID;
+  header.driverVersion = properties.driverVersion;
+  std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  return header;
+}
+
+}  // namespace
+
+VvtPipelineCache::VvtPipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, std::string filePath)
+    : device{device}, properties{properties}, filePath{std::move(filePath)} {
+  VVT_PROFILE_FUNCTION();
+  std::vector<char> data;
+  warm = load(data);
+
+  VkPipelineCacheCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.initialDataSize = warm ? data.size() : 0;
+  createInfo.pInitialData = warm ? data.data() : nullptr;
+  if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+}
+
+VvtPipelineCache::~VvtPipelineCache() {
+  if (!store()) {
+    std::cerr << "Failed to write the pipeline cache file " << filePath << std::endl;
+  }
+  vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+bool VvtPipelineCache::load(std::vector<char> &data) const {
+  if (filePath.empty()) {
+    return false;
+  }
+  std::ifstream file{filePath, std::ios::binary};
+  if (!file.is_open()) {
+    return false;
+  }
+
+  PipelineCacheFileHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  PipelineCacheFileHeader expected = createHeader(properties);
+  if (!file || std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+      header.version != expected.version || header.vendorID != expected.vendorID ||
+      header.deviceID != expected.deviceID || header.driverVersion != expected.driverVersion ||
+      std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+    return false;
+  }
+
+  // The data has to fill the rest of the file exactly, which also keeps a corrupted size from allocating too much
+  std::error_code error;
+  uint64_t fileSize = static_cast<uint64_t>(std::filesystem::file_size(filePath, error));
+  if (error || fileSize != sizeof(header) + header.dataSize) {
+    return false;
+  }
+  data.resize(static_cast<size_t>(header.dataSize));
+  file.read(data.data(), static_cast<std::streamsize>(data.size()));
+  return file && header.checksum == checksum(header, data);
+}
+
+bool VvtPipelineCache::store() const {
+  VVT_PROFILE_FUNCTION();
+  if (filePath.empty()) {
+    return true;
+  }
+
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS) {
+    return false;
+  }
+  std::vector<char> data(dataSize);
+  if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS) {
+    return false;
+  }
+  data.resize(dataSize);
+
+  PipelineCacheFileHeader header = createHeader(properties);
+  header.dataSize = dataSize;
+  header.checksum = checksum(header, data);
+
+  // Write to a temporary file first, so a crash never leaves a truncated cache behind
+  std::error_code error;
+  std::filesystem::path parent = std::filesystem::path{filePath}.parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent, error);
+  }
+  std::string tempFilePath = filePath + ".tmp";
+  {
+    std::ofstream file{tempFilePath, std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tempFilePath, filePath, error);
+  if (error) {
+    std::filesystem::remove(tempFilePath, error);
+    return false;
+  }
+  return true;
+}
+
+const std::vector<char> &VvtPipelineCache::getShaderCode(const std::string &shaderPath) {
+  std::lock_guard<std::mutex> lock{mutex};
+  auto it = shaderCode.find(shaderPath);
+  if (it != shaderCode.end()) {
+    return it->second;
+  }
+
+  std::ifstream file{shaderPath, std::ios::ate | std::ios::binary};
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open file: " + shaderPath);
+  }
+  std::vector<char> code(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(code.data(), static_cast<std::streamsize>(code.size()));
+  return shaderCode.emplace(shaderPath, std::move(code)).first->second;
+}
+
+void VvtPipelineCache::setShaderCode(const std::string &shaderPath, std::vector<char> code) {
+  std::lock_guard<std::mutex> lock{mutex};
+  shaderCode[shaderPath] = std::move(code);
+}
+
+void VvtPipelineCache::recordPipelineCreation(double milliseconds) {
+  std::lock_guard<std::mutex> lock{mutex};
+  pipelineCount++;
+  creationMilliseconds += milliseconds;
+}
+
+uint32_t VvtPipelineCache::getPipelineCount() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return pipelineCount;
+}
+
+double VvtPipelineCache::getCreationMilliseconds() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return creationMilliseconds;
+}
+
+}  // namespace vvt
@@ -0,0 +1,60 @@
+#pragma once
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vvt {
+
+/*
+ * VkPipelineCache of the device, loaded from a file at creation and written back when it is destroyed. The file is
+ * only used if it was written for the same vendor, device, driver version and pipeline cache UUID. SPIR-V files are
+ * read once and kept for the pipelines created from them, creation times of the pipelines are collected for the UI.
+ */
+class VvtPipelineCache {
+ public:
+  // Without a file path the cache only lives as long as the device
+  VvtPipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, std::string filePath = {});
+  ~VvtPipelineCache();
+
+  VvtPipelineCache(const VvtPipelineCache &) = delete;
+  VvtPipelineCache &operator=(const VvtPipelineCache &) = delete;
+
+  VkPipelineCache getCache() const { return cache; }
+  // Whether the cache started from the file, i.e. pipelines were compiled before on this driver
+  bool isWarm() const { return warm; }
+
+  // Failing to write is not an error, the pipelines will just be compiled again next time
+  bool store() const;
+
+  // Throws if the file cannot be read, the code stays valid until it is replaced
+  const std::vector<char> &getShaderCode(const std::string &shaderPath);
+  // E.g. after the shader was recompiled, pipelines created from now on use the new code
+  void setShaderCode(const std::string &shaderPath, std::vector<char> code);
+
+  void recordPipelineCreation(double milliseconds);
+  uint32_t getPipelineCount() const;
+  double getCreationMilliseconds() const;
+
+ private:
+  bool load(std::vector<char> &data) const;
+
+  VkDevice device;
+  VkPhysicalDeviceProperties properties;
+  std::string filePath;
+  VkPipelineCache cache = VK_NULL_HANDLE;
+  bool warm = false;
+
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, std::vector<char>> shaderCode;
+  uint32_t pipelineCount = 0;
+  double creationMilliseconds = 0.0;
+};
+
+}  // namespace vvt
@@ -0,0 +1,43 @@
+#include "vvt_pipeline_registry.hpp"
+
+namespace vvt {
+
+	VvtPipeline& VvtPipelineRegistry::get(uint64_t key, VkRenderPass renderPass, const CreateFunction& create)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		Variant& variant = variants[key];
+		if (!variant.pipeline)
+		{
+			variant.pipeline = create(renderPass);
+			variant.create = create;
+		}
+		return *variant.pipeline;
+	}
+
+	uint32_t VvtPipelineRegistry::getVariantCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return static_cast<uint32_t>(variants.size());
+	}
+
+	void VvtPipelineRegistry::recreate(VkRenderPass renderPass, std::vector<std::unique_ptr<VvtPipeline>>& retired)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		std::vector<std::pair<uint64_t, std::unique_ptr<VvtPipeline>>> created;
+		created.reserve(variants.size());
+		for (auto& [key, variant] : variants)
+		{
+			if (variant.create)
+			{
+				created.emplace_back(key, variant.create(renderPass));
+			}
+		}
+
+		for (auto& [key, pipeline] : created)
+		{
+			Variant& variant = variants[key];
+			retired.push_back(std::move(variant.pipeline));
+			variant.pipeline = std::move(pipeline);
+		}
+	}
+}
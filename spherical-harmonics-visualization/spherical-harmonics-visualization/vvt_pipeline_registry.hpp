@@ -0,0 +1,49 @@
+#pragma once
+#include "vvt_pipeline.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Pipeline variants of one pipeline layout, e.g. the specializations of a shader, keyed by a value that encodes
+	* everything that tells them apart. Variants are created the first time they are asked for and live as long as
+	* the registry. Lookups may come from several recording threads, creation is serialized. The render pass is passed
+	* to every creation instead of being kept, since the swap chain replaces its render pass when it is recreated.
+	*/
+	class VvtPipelineRegistry
+	{
+	public:
+		using CreateFunction = std::function<std::unique_ptr<VvtPipeline>(VkRenderPass renderPass)>;
+
+		VvtPipelineRegistry() = default;
+
+		VvtPipelineRegistry(const VvtPipelineRegistry&) = delete;
+		VvtPipelineRegistry& operator=(const VvtPipelineRegistry&) = delete;
+
+		// Calls create if there is no variant with this key yet, the function is kept to recreate the variant
+		VvtPipeline& get(uint64_t key, VkRenderPass renderPass, const CreateFunction& create);
+		uint32_t getVariantCount() const;
+
+		/*
+		* Creates all variants again, e.g. after their shaders changed. The old pipelines are moved to retired, since
+		* command buffers may still use them. If creating one throws, all variants are left as they were.
+		*/
+		void recreate(VkRenderPass renderPass, std::vector<std::unique_ptr<VvtPipeline>>& retired);
+
+	private:
+		struct Variant {
+			std::unique_ptr<VvtPipeline> pipeline;
+			CreateFunction create;
+		};
+
+		mutable std::mutex mutex;
+		std::unordered_map<uint64_t, Variant> variants;
+	};
+}
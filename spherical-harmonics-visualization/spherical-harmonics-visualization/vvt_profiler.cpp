@@ -0,0 +1,159 @@
+#include "vvt_profiler.hpp"
+
+#ifdef VVT_ENABLE_PROFILING
+
+// std
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace vvt {
+
+	namespace {
+
+		constexpr uint32_t EVENTS_PER_CHUNK = 4096;
+
+		/*
+		* Events of one thread. Only the owning thread appends, the count of a chunk is published with release
+		* semantics after the event was written, so the trace writer can read every published event without a lock.
+		*/
+		struct EventChunk {
+			std::array<VvtProfiler::Event, EVENTS_PER_CHUNK> events;
+			std::atomic<uint32_t> count{ 0 };
+			std::atomic<EventChunk*> next{ nullptr };
+		};
+
+		struct ThreadBuffer {
+			uint32_t threadId = 0;
+			std::atomic<const char*> name{ nullptr };
+			std::unique_ptr<EventChunk> head = std::make_unique<EventChunk>();
+			EventChunk* tail = head.get();	// Owning thread only
+
+			~ThreadBuffer()
+			{
+				// Chunks after the head are owned through the next pointers
+				EventChunk* chunk = head->next.load();
+				while (chunk)
+				{
+					EventChunk* next = chunk->next.load();
+					delete chunk;
+					chunk = next;
+				}
+			}
+		};
+
+		// Buffers outlive their threads, so the trace still contains the zones of finished threads
+		struct ThreadRegistry {
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		};
+
+		ThreadRegistry& getRegistry()
+		{
+			static ThreadRegistry registry;
+			return registry;
+		}
+
+		/* The registry lock is only taken once per thread, when it records its first event */
+		ThreadBuffer& getThreadBuffer()
+		{
+			thread_local ThreadBuffer* buffer = nullptr;
+			if (!buffer)
+			{
+				ThreadRegistry& registry = getRegistry();
+				std::lock_guard<std::mutex> lock{ registry.mutex };
+				registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+				buffer = registry.buffers.back().get();
+				buffer->threadId = static_cast<uint32_t>(registry.buffers.size());
+			}
+			return *buffer;
+		}
+
+		void writeJsonString(std::ofstream& out, const char* text)
+		{
+			out << '"';
+			for (const char* c = text; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					out << '\\';
+				}
+				out << *c;
+			}
+			out << '"';
+		}
+	}
+
+	const std::chrono::steady_clock::time_point VvtProfiler::epoch = std::chrono::steady_clock::now();
+
+	void VvtProfiler::record(const char* name, int64_t start, int64_t end)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+		EventChunk* chunk = buffer.tail;
+
+		uint32_t index = chunk->count.load(std::memory_order_relaxed);
+		if (index == EVENTS_PER_CHUNK)
+		{
+			EventChunk* next = new EventChunk();
+			chunk->next.store(next, std::memory_order_release);
+			buffer.tail = next;
+			chunk = next;
+			index = 0;
+		}
+
+		chunk->events[index] = { name, start, end - start };
+		chunk->count.store(index + 1, std::memory_order_release);
+	}
+
+	void VvtProfiler::setThreadName(const char* name)
+	{
+		getThreadBuffer().name.store(name, std::memory_order_release);
+	}
+
+	void VvtProfiler::writeChromeTrace(const std::string& filepath)
+	{
+		std::ofstream out{ filepath };
+		if (!out.is_open())
+		{
+			throw std::runtime_error("Failed to open " + filepath);
+		}
+
+		ThreadRegistry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock{ registry.mutex };
+
+		// Complete events ("X") with microsecond timestamps, plus one metadata event per named thread
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		for (const auto& buffer : registry.buffers)
+		{
+			if (const char* name = buffer->name.load(std::memory_order_acquire))
+			{
+				out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+				writeJsonString(out, name);
+				out << "}}";
+				first = false;
+			}
+
+			for (const EventChunk* chunk = buffer->head.get(); chunk; chunk = chunk->next.load(std::memory_order_acquire))
+			{
+				uint32_t count = chunk->count.load(std::memory_order_acquire);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const Event& event = chunk->events[i];
+					out << (first ? "" : ",") << "\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"name\":";
+					writeJsonString(out, event.name);
+					out << ",\"ts\":" << event.start / 1000 << "." << event.start % 1000 / 100
+						<< ",\"dur\":" << event.duration / 1000 << "." << event.duration % 1000 / 100 << "}";
+					first = false;
+				}
+			}
+		}
+		out << "\n]}\n";
+	}
+}
+
+#endif
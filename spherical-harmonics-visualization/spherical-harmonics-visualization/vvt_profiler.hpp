@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+* CPU zone profiler. Zones are recorded with the VVT_PROFILE_* macros below and written as Chrome Trace Event JSON,
+* which can be opened in chrome://tracing or https://ui.perfetto.dev.
+*
+* Everything is compiled out unless VVT_ENABLE_PROFILING is defined (Debug configurations), the macros expand to
+* nothing then and no profiler code is linked.
+*/
+#ifdef VVT_ENABLE_PROFILING
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace vvt {
+
+	class VvtProfiler
+	{
+	public:
+		// Names have to outlive the profiler, string literals and __FUNCTION__ do
+		struct Event {
+			const char* name;
+			int64_t start;		// Nanoseconds since the profiler epoch
+			int64_t duration;
+		};
+
+		static int64_t now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+		}
+
+		// Appends to the buffer of the calling thread without taking any lock
+		static void record(const char* name, int64_t start, int64_t end);
+		static void setThreadName(const char* name);
+
+		// Can be called while other threads keep recording, their newest events may be missing then
+		static void writeChromeTrace(const std::string& filepath);
+
+	private:
+		static const std::chrono::steady_clock::time_point epoch;
+	};
+
+	class VvtProfileZone
+	{
+	public:
+		explicit VvtProfileZone(const char* name) : name{ name }, start{ VvtProfiler::now() } {}
+		~VvtProfileZone() { VvtProfiler::record(name, start, VvtProfiler::now()); }
+
+		VvtProfileZone(const VvtProfileZone&) = delete;
+		VvtProfileZone& operator=(const VvtProfileZone&) = delete;
+
+	private:
+		const char* name;
+		int64_t start;
+	};
+}
+
+#define VVT_PROFILE_CONCAT_INNER(a, b) a##b
+#define VVT_PROFILE_CONCAT(a, b) VVT_PROFILE_CONCAT_INNER(a, b)
+
+#define VVT_PROFILE_SCOPE(name) ::vvt::VvtProfileZone VVT_PROFILE_CONCAT(vvtProfileZone, __LINE__){ name }
+#define VVT_PROFILE_FUNCTION() VVT_PROFILE_SCOPE(__FUNCTION__)
+#define VVT_PROFILE_THREAD_NAME(name) ::vvt::VvtProfiler::setThreadName(name)
+#define VVT_PROFILE_WRITE_TRACE(filepath) ::vvt::VvtProfiler::writeChromeTrace(filepath)
+
+#else
+
+#define VVT_PROFILE_SCOPE(name)
+#define VVT_PROFILE_FUNCTION()
+#define VVT_PROFILE_THREAD_NAME(name)
+#define VVT_PROFILE_WRITE_TRACE(filepath)
+
+#endif
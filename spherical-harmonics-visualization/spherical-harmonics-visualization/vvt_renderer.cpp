@@ -1,4 +1,5 @@
 #include "vvt_renderer.hpp"
+#include "vvt_profiler.hpp"
 
 // std
 #include <cassert>
@@ -7,10 +8,19 @@
 
 namespace vvt {
 
-	VvtRenderer::VvtRenderer(VvtWindow & window, VvtDevice & device) : vvtWindow{window}, vvtDevice{device}
+	VvtRenderer::VvtRenderer(VvtWindow & window, VvtDevice & device) : vvtWindow{&window}, vvtDevice{device}
 	{
 		recreateSwapchain();
 		createCommandBuffers();
+		gpuProfiler = std::make_unique<VvtGpuProfiler>(vvtDevice, VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
+	}
+
+	VvtRenderer::VvtRenderer(VvtDevice& device, VkExtent2D extent) : vvtWindow{nullptr}, vvtDevice{device}
+	{
+		assert(device.isHeadless() && "A headless renderer needs a headless device!");
+		offscreenTarget = std::make_unique<VvtOffscreenTarget>(vvtDevice, extent);
+		createCommandBuffers();
+		gpuProfiler = std::make_unique<VvtGpuProfiler>(vvtDevice, VvtSwapChain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	VvtRenderer::~VvtRenderer()
@@ -21,11 +31,11 @@ namespace vvt {
 
 	void VvtRenderer::recreateSwapchain()
 	{
-		auto extent = vvtWindow.getExtent();
+		auto extent = vvtWindow->getExtent();
 		while (extent.width == 0 || extent.height == 0)
 		{
 			// Let the program pause and wait when at least 1 dimension is 0.
-			extent = vvtWindow.getExtent();
+			extent = vvtWindow->getExtent();
 			glfwWaitEvents();
 		}
 		vkDeviceWaitIdle(vvtDevice.device());
@@ -58,6 +68,12 @@ namespace vvt {
 		}
 	}
 
+	float VvtRenderer::getGpuFrameTime() const
+	{
+		const VvtGpuProfiler::ScopeHistory* frameScope = gpuProfiler->findScope("Frame");
+		return frameScope ? gpuProfiler->getLatestTime(*frameScope) : -1.0f;
+	}
+
 	void VvtRenderer::freeCommandBuffers()
 	{
 		vkFreeCommandBuffers(vvtDevice.device(), vvtDevice.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
@@ -68,8 +84,9 @@ namespace vvt {
 	VkCommandBuffer VvtRenderer::beginFrame()
 	{
 		assert(!isFrameStarted && "Cannot call beginFrame when frame has already started!");
+		VVT_PROFILE_FUNCTION();
 
-		auto result = vvtSwapChain->acquireNextImage(&currentImageIndex);
+		auto result = isHeadless() ? offscreenTarget->acquireNextImage(&currentImageIndex) : vvtSwapChain->acquireNextImage(&currentImageIndex);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			recreateSwapchain();
 			return nullptr;
@@ -88,41 +105,57 @@ namespace vvt {
 			throw std::runtime_error("failed to begin recording command buffer!");
 		}
 
+		// The fence of this frame slot was waited on by acquireNextImage, so its old timestamps are ready
+		gpuProfiler->beginFrame(commandBuffer, currentFrameIndex);
+		gpuProfiler->beginScope(commandBuffer, "Frame");
+
 		return commandBuffer;
 	}
 
 	void VvtRenderer::endFrame()
 	{
 		assert(isFrameStarted && "Cannot end the frame when there is no current frame in progress!");
+		VVT_PROFILE_SCOPE("VvtRenderer::endFrame (submit + present)");
 		auto commandBuffer = getCurrentCommandBuffer();
+		gpuProfiler->endScope(commandBuffer);
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to record command buffer!");
 		}
 
-		auto result = vvtSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vvtWindow.wasWindowResized()) {
-			vvtWindow.resetWindowResizedFlag();
-			recreateSwapchain();
+		// Uploads recorded while building the frame are submitted ahead of it, queue order makes them visible to it
+		vvtDevice.getUploadManager().flush();
+
+		if (isHeadless()) {
+			if (offscreenTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex) != VK_SUCCESS) {
+				throw std::runtime_error("failed to submit offscreen command buffer!");
+			}
 		}
-		else if (result != VK_SUCCESS) {
-			throw std::runtime_error("failed to present swap chain image!");
+		else {
+			auto result = vvtSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vvtWindow->wasWindowResized()) {
+				vvtWindow->resetWindowResizedFlag();
+				recreateSwapchain();
+			}
+			else if (result != VK_SUCCESS) {
+				throw std::runtime_error("failed to present swap chain image!");
+			}
 		}
 		isFrameStarted = false;
 		currentFrameIndex = (currentFrameIndex + 1) % VvtSwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void VvtRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void VvtRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Cannot begin the render pass when there is no current frame in progress!");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Cannot begin render pass on command buffer from a different frame!");
 
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = vvtSwapChain->getRenderPass();
-		renderPassInfo.framebuffer = vvtSwapChain->getFrameBuffer(currentImageIndex);
+		renderPassInfo.renderPass = getSwapChainRenderPass();
+		renderPassInfo.framebuffer = getCurrentFrameBuffer();
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = vvtSwapChain->getSwapChainExtent();
+		renderPassInfo.renderArea.extent = getExtent();
 
 		std::array<VkClearValue, 2> clearValues{};
 		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
@@ -130,16 +163,20 @@ namespace vvt {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		gpuProfiler->beginScope(commandBuffer, "Scene pass");
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(vvtSwapChain->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(vvtSwapChain->getSwapChainExtent().height);
+		viewport.width = static_cast<float>(getExtent().width);
+		viewport.height = static_cast<float>(getExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{ {0, 0}, vvtSwapChain->getSwapChainExtent() };
+		VkRect2D scissor{ {0, 0}, getExtent() };
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
@@ -149,6 +186,7 @@ namespace vvt {
 		assert(isFrameStarted && "Cannot end the render pass when there is no current frame in progress!");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Cannot end render pass on command buffer from a different frame!");
 		vkCmdEndRenderPass(commandBuffer);
+		gpuProfiler->endScope(commandBuffer);
 	}
 
 	void VvtRenderer::beginImGuiRenderPass(VkCommandBuffer commandBuffer)
@@ -158,7 +196,7 @@ namespace vvt {
 
 		VkRenderPassBeginInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		info.renderPass = vvtSwapChain->getImGuiRenderPass();
+		info.renderPass = getImGuiRenderPass();
 		info.framebuffer = vvtSwapChain->getFrameBuffer(currentImageIndex);
 		info.renderArea.extent = vvtSwapChain->getSwapChainExtent();
 		info.clearValueCount = 1;
@@ -168,6 +206,7 @@ namespace vvt {
 		info.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		info.pClearValues = clearValues.data();
 
+		gpuProfiler->beginScope(commandBuffer, "ImGui pass");
 		vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
 	}
 
@@ -176,6 +215,7 @@ namespace vvt {
 		assert(isFrameStarted && "Cannot end the render pass when there is no current frame in progress!");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Cannot end render pass on command buffer from a different frame!");
 		vkCmdEndRenderPass(commandBuffer);
+		gpuProfiler->endScope(commandBuffer);
 	}
 
 
@@ -1,5 +1,7 @@
 #pragma once
 #include "vvt_swap_chain.hpp"
+#include "vvt_offscreen_target.hpp"
+#include "vvt_gpu_profiler.hpp"
 #include "vvt_pipeline.hpp"
 #include "vvt_device.hpp"
 #include "vvt_window.hpp"
@@ -15,14 +17,27 @@ namespace vvt {
 	public:
 
 		VvtRenderer(VvtWindow& window, VvtDevice& device);
+
+		// Headless renderer, frames are rendered into offscreen images of the given extent and never presented
+		VvtRenderer(VvtDevice& device, VkExtent2D extent);
 		~VvtRenderer();
 
 		VvtRenderer(const VvtRenderer&) = delete;
 		VvtRenderer& operator=(const VvtRenderer&) = delete;
 
-		VkRenderPass getSwapChainRenderPass() const { return vvtSwapChain->getRenderPass(); };
-		VkRenderPass getImGuiRenderPass() const { return vvtSwapChain->getImGuiRenderPass(); };
-		float getAspectRatio() const { return vvtSwapChain->extentAspectRatio(); };
+		bool isHeadless() const { return vvtWindow == nullptr; };
+		VkRenderPass getSwapChainRenderPass() const { return isHeadless() ? offscreenTarget->getRenderPass() : vvtSwapChain->getRenderPass(); };
+		VkRenderPass getImGuiRenderPass() const {
+			assert(!isHeadless() && "There is no ImGui render pass when rendering headless!");
+			return vvtSwapChain->getImGuiRenderPass();
+		};
+		VkExtent2D getExtent() const { return isHeadless() ? offscreenTarget->getExtent() : vvtSwapChain->getSwapChainExtent(); };
+		float getAspectRatio() const { return isHeadless() ? offscreenTarget->extentAspectRatio() : vvtSwapChain->extentAspectRatio(); };
+
+		// Scopes "Frame", "Scene pass" and "ImGui pass" are recorded by the renderer, render systems can add their own
+		VvtGpuProfiler& getGpuProfiler() { return *gpuProfiler; };
+		// GPU time of the last frame whose timestamps are available (MAX_FRAMES_IN_FLIGHT frames ago), negative if unsupported
+		float getGpuFrameTime() const;
 		bool isFrameInProgress() const { return isFrameStarted; };
 		VkCommandBuffer getCurrentCommandBuffer() const {
 			assert(isFrameStarted && "Cannot access command buffer when frame not in progress!");
@@ -35,7 +50,8 @@ namespace vvt {
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// With secondary command buffer contents the viewport and scissor have to be set by the secondary command buffers
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 		void beginImGuiRenderPass(VkCommandBuffer commandBuffer);
 		void endImGuiRenderPass(VkCommandBuffer commandBuffer);
@@ -47,15 +63,20 @@ namespace vvt {
 		void freeCommandBuffers();
 		void recreateSwapchain();
 
+		VkFramebuffer getCurrentFrameBuffer() const { return isHeadless() ? offscreenTarget->getFrameBuffer(currentImageIndex) : vvtSwapChain->getFrameBuffer(currentImageIndex); };
 
-		VvtWindow& vvtWindow;
+
+		VvtWindow* vvtWindow;
 		VvtDevice& vvtDevice;
 		std::unique_ptr<VvtSwapChain> vvtSwapChain;
+		std::unique_ptr<VvtOffscreenTarget> offscreenTarget;
 		std::vector<VkCommandBuffer> commandBuffers;
 
-		uint32_t currentImageIndex;
-		int currentFrameIndex;
-		bool isFrameStarted;
+		std::unique_ptr<VvtGpuProfiler> gpuProfiler;
+
+		uint32_t currentImageIndex = 0;
+		int currentFrameIndex = 0;
+		bool isFrameStarted = false;
 	};
 }
 
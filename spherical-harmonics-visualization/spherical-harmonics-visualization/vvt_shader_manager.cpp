@@ -0,0 +1,290 @@
+#include "vvt_shader_manager.hpp"
+#include "vvt_profiler.hpp"
+
+// libs
+#ifdef VVT_ENABLE_SHADER_HOT_RELOAD
+#include <shaderc/shaderc.hpp>
+#endif
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <system_error>
+
+namespace vvt {
+
+	namespace {
+
+		// Same as compile.bat producing it, so the next start doesn't need the old code anymore
+		bool writeSpirv(const std::string& spirvPath, const std::vector<char>& spirv)
+		{
+			std::string tempPath = spirvPath + ".tmp";
+			{
+				std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+				if (!file.is_open())
+				{
+					return false;
+				}
+				file.write(spirv.data(), static_cast<std::streamsize>(spirv.size()));
+				if (!file)
+				{
+					return false;
+				}
+			}
+
+			std::error_code error;
+			std::filesystem::rename(tempPath, spirvPath, error);
+			if (error)
+			{
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+			return true;
+		}
+
+		// Files named by quoted #include directives of the source, and recursively of the files they include
+		void findIncludes(const std::filesystem::path& sourcePath, std::vector<std::string>& includes)
+		{
+			std::ifstream file{ sourcePath };
+			std::string line;
+			while (std::getline(file, line))
+			{
+				size_t directive = line.find_first_not_of(" \t");
+				if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+				{
+					continue;
+				}
+				size_t open = line.find('"', directive);
+				size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+				if (close == std::string::npos)
+				{
+					continue;
+				}
+
+				std::string path = (sourcePath.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal().string();
+				if (std::find(includes.begin(), includes.end(), path) == includes.end())
+				{
+					includes.push_back(path);
+					findIncludes(path, includes);
+				}
+			}
+		}
+
+		std::vector<std::string> findDependencies(const std::string& sourcePath)
+		{
+			std::vector<std::string> dependencies{ sourcePath };
+			findIncludes(sourcePath, dependencies);
+			return dependencies;
+		}
+
+		std::filesystem::file_time_type getNewestWriteTime(const std::vector<std::string>& paths, std::error_code& error)
+		{
+			std::filesystem::file_time_type newest{};
+			for (const auto& path : paths)
+			{
+				auto writeTime = std::filesystem::last_write_time(path, error);
+				if (error)
+				{
+					return newest;
+				}
+				newest = std::max(newest, writeTime);
+			}
+			return newest;
+		}
+
+#ifdef VVT_ENABLE_SHADER_HOT_RELOAD
+		// Resolves #include "file" relative to the including file and #include <file> relative to the working directory, like glslc
+		class SourceIncluder : public shaderc::CompileOptions::IncluderInterface
+		{
+		public:
+			shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+			{
+				std::filesystem::path path = requestedSource;
+				if (type == shaderc_include_type_relative)
+				{
+					path = std::filesystem::path{ requestingSource }.parent_path() / path;
+				}
+
+				// shaderc reports an include with an empty source name as error, with the content as message
+				auto include = new Include{};
+				std::ifstream file{ path, std::ios::binary };
+				if (file.is_open())
+				{
+					include->sourceName = path.lexically_normal().string();
+					include->content.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+				}
+				else
+				{
+					include->content = "Failed to open file: " + path.string();
+				}
+
+				include->result.source_name = include->sourceName.c_str();
+				include->result.source_name_length = include->sourceName.size();
+				include->result.content = include->content.c_str();
+				include->result.content_length = include->content.size();
+				include->result.user_data = include;
+				return &include->result;
+			}
+
+			void ReleaseInclude(shaderc_include_result* data) override
+			{
+				delete static_cast<Include*>(data->user_data);
+			}
+
+		private:
+			struct Include {
+				std::string sourceName;
+				std::string content;
+				shaderc_include_result result;
+			};
+		};
+#endif
+	}
+
+	VvtShaderManager::VvtShaderManager(VvtPipelineCache& pipelineCache) : pipelineCache{ pipelineCache }
+	{
+	}
+
+	VvtShaderManager::~VvtShaderManager()
+	{
+		// The compile threads only touch their own copies, but the futures of std::async block here anyway
+		for (auto& shader : shaders)
+		{
+			if (shader.job.valid())
+			{
+				shader.job.wait();
+			}
+		}
+	}
+
+	void VvtShaderManager::watch(const std::string& spirvPath, const std::string& sourcePath, const std::vector<std::string>& defines)
+	{
+		for (const auto& shader : shaders)
+		{
+			if (shader.spirvPath == spirvPath)
+			{
+				return;
+			}
+		}
+
+		WatchedShader shader{};
+		shader.spirvPath = spirvPath;
+		shader.sourcePath = sourcePath;
+		shader.defines = defines;
+		shader.dependencies = findDependencies(sourcePath);
+		std::error_code error;
+		shader.writeTime = getNewestWriteTime(shader.dependencies, error);
+		shaders.push_back(std::move(shader));
+	}
+
+	bool VvtShaderManager::poll()
+	{
+#ifdef VVT_ENABLE_SHADER_HOT_RELOAD
+		VVT_PROFILE_FUNCTION();
+		bool changed = false;
+		for (auto& shader : shaders)
+		{
+			if (!shader.job.valid() || shader.job.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+			{
+				continue;
+			}
+
+			// Includes might have been added or removed by the edit
+			CompileResult result = shader.job.get();
+			shader.dependencies = findDependencies(shader.sourcePath);
+			if (!result.success)
+			{
+				status = "Failed to compile " + shader.sourcePath + ", keeping the previous shader:\n" + result.message;
+				std::cerr << status << std::endl;
+				continue;
+			}
+
+			if (!writeSpirv(shader.spirvPath, result.spirv))
+			{
+				std::cerr << "Failed to write " << shader.spirvPath << std::endl;
+			}
+			pipelineCache.setShaderCode(shader.spirvPath, std::move(result.spirv));
+			status = "Reloaded " + shader.sourcePath;
+			std::cout << status << std::endl;
+			changed = true;
+		}
+
+		// Checking the sources costs a system call per file, there is no need to do that every frame
+		auto now = std::chrono::steady_clock::now();
+		if (now - lastCheck < CHECK_INTERVAL)
+		{
+			return changed;
+		}
+		lastCheck = now;
+
+		for (auto& shader : shaders)
+		{
+			if (shader.job.valid())
+			{
+				continue;
+			}
+			std::error_code error;
+			auto writeTime = getNewestWriteTime(shader.dependencies, error);
+			if (error || writeTime == shader.writeTime)
+			{
+				continue;
+			}
+
+			// Saves during the compile are picked up by the next check after it finished
+			shader.writeTime = writeTime;
+			shader.job = std::async(std::launch::async, &VvtShaderManager::compile, shader.sourcePath, shader.defines);
+		}
+		return changed;
+#else
+		return false;
+#endif
+	}
+
+	VvtShaderManager::CompileResult VvtShaderManager::compile(const std::string& sourcePath, const std::vector<std::string>& defines)
+	{
+		CompileResult result{};
+#ifdef VVT_ENABLE_SHADER_HOT_RELOAD
+		VVT_PROFILE_THREAD_NAME("Shader compiler");
+		VVT_PROFILE_FUNCTION();
+		std::ifstream file{ sourcePath, std::ios::binary };
+		if (!file.is_open())
+		{
+			result.message = "Failed to open file: " + sourcePath;
+			return result;
+		}
+		std::string source{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+		// The stage follows from the extension, like glslc infers it
+		std::filesystem::path extension = std::filesystem::path{ sourcePath }.extension();
+		shaderc_shader_kind kind = extension == ".frag" ? shaderc_glsl_fragment_shader : shaderc_glsl_vertex_shader;
+
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		for (const auto& define : defines)
+		{
+			options.AddMacroDefinition(define);
+		}
+		options.SetIncluder(std::make_unique<SourceIncluder>());
+
+		shaderc::Compiler compiler;
+		shaderc::SpvCompilationResult spirv = compiler.CompileGlslToSpv(source, kind, sourcePath.c_str(), options);
+		if (spirv.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			result.message = spirv.GetErrorMessage();
+			return result;
+		}
+
+		const char* begin = reinterpret_cast<const char*>(spirv.cbegin());
+		const char* end = reinterpret_cast<const char*>(spirv.cend());
+		result.spirv.assign(begin, end);
+		result.success = true;
+#else
+		result.message = "Shader hot reload is not enabled in this build";
+#endif
+		return result;
+	}
+}
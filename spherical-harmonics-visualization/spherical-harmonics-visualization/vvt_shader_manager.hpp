@@ -0,0 +1,65 @@
+#pragma once
+#include "vvt_pipeline_cache.hpp"
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Watches the GLSL sources of SPIR-V files and recompiles them with libshaderc when they change. Compiles run on
+	* their own thread, poll only collects finished ones, so the render loop never waits for the compiler. New code is
+	* put into the pipeline cache (and written to the SPIR-V file), pipelines have to be recreated to pick it up.
+	* A source that fails to compile leaves the previous code in place. Quoted #include directives are resolved relative
+	* to the including file, and a change to any included file recompiles the shaders that include it.
+	*
+	* Only active if VVT_ENABLE_SHADER_HOT_RELOAD is defined (Debug configurations), otherwise poll never reports changes.
+	*/
+	class VvtShaderManager
+	{
+	public:
+		static constexpr std::chrono::milliseconds CHECK_INTERVAL{ 500 };
+
+		explicit VvtShaderManager(VvtPipelineCache& pipelineCache);
+		~VvtShaderManager();
+
+		VvtShaderManager(const VvtShaderManager&) = delete;
+		VvtShaderManager& operator=(const VvtShaderManager&) = delete;
+
+		// Watches sourcePath for changes from now on, defines are passed to the preprocessor like glslc -D does
+		void watch(const std::string& spirvPath, const std::string& sourcePath, const std::vector<std::string>& defines = {});
+
+		// Call once per frame. True if new code arrived for a shader since the last call
+		bool poll();
+		// Result of the latest compile, for the UI
+		const std::string& getStatus() const { return status; }
+
+	private:
+		struct CompileResult {
+			bool success = false;
+			std::vector<char> spirv;
+			std::string message;
+		};
+
+		struct WatchedShader {
+			std::string spirvPath;
+			std::string sourcePath;
+			std::vector<std::string> defines;
+			std::vector<std::string> dependencies;	// The source and every file it includes
+			std::filesystem::file_time_type writeTime;	// Newest write time of the dependencies
+			std::future<CompileResult> job;
+		};
+
+		static CompileResult compile(const std::string& sourcePath, const std::vector<std::string>& defines);
+
+		VvtPipelineCache& pipelineCache;
+		std::vector<WatchedShader> shaders;
+		std::chrono::steady_clock::time_point lastCheck{};
+		std::string status;
+	};
+}
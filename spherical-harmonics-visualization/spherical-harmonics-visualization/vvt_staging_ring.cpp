@@ -0,0 +1,60 @@
+#include "vvt_staging_ring.hpp"
+#include "vvt_device.hpp"
+
+// std
+#include <cassert>
+
+namespace vvt {
+
+VvtStagingRing::VvtStagingRing(VvtDevice &device, VkDeviceSize size) : device{device}, size{size} {
+  assert((size & (size - 1)) == 0 && "The staging ring needs a power of two size!");
+  device.createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      buffer,
+      memory);
+}
+
+VvtStagingRing::~VvtStagingRing() { device.destroyBuffer(buffer, memory); }
+
+bool VvtStagingRing::allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, Region &region) {
+  assert((alignment & (alignment - 1)) == 0 && alignment <= size && "Invalid staging alignment!");
+  std::lock_guard<std::mutex> lock{mutex};
+
+  // The size is a power of two, so aligned positions are aligned offsets in the buffer as well
+  uint64_t start = (head + alignment - 1) & ~(alignment - 1);
+  VkDeviceSize offset = start % size;
+  if (offset + allocationSize > size) {
+    // Never split a region at the end of the buffer, skip to the start instead
+    start += size - offset;
+    offset = 0;
+  }
+  if (start + allocationSize - tail > size) {
+    return false;
+  }
+
+  head = start + allocationSize;
+  region.buffer = buffer;
+  region.offset = offset;
+  region.mapped = static_cast<char *>(memory.mapped) + offset;
+  return true;
+}
+
+uint64_t VvtStagingRing::getHead() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return head;
+}
+
+void VvtStagingRing::release(uint64_t position) {
+  std::lock_guard<std::mutex> lock{mutex};
+  assert(position >= tail && position <= head && "Staging ranges have to be released in order!");
+  tail = position;
+}
+
+VkDeviceSize VvtStagingRing::getUsedBytes() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return head - tail;
+}
+
+}  // namespace vvt
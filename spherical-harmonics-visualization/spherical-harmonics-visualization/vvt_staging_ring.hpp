@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vvt_allocator.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <mutex>
+
+namespace vvt {
+
+class VvtDevice;
+
+/*
+ * One persistently mapped host visible buffer that staging data is written into front to back, wrapping around at
+ * the end. Positions are counted in bytes since creation, so the ranges of consecutive submissions can be freed
+ * in order by handing the position after their last allocation back to release, once their fence has signaled.
+ */
+class VvtStagingRing {
+ public:
+  static constexpr VkDeviceSize DEFAULT_SIZE = 32ull << 20;
+
+  struct Region {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    void *mapped = nullptr;
+  };
+
+  VvtStagingRing(VvtDevice &device, VkDeviceSize size = DEFAULT_SIZE);
+  ~VvtStagingRing();
+
+  VvtStagingRing(const VvtStagingRing &) = delete;
+  VvtStagingRing &operator=(const VvtStagingRing &) = delete;
+
+  // False if the ring is too small or still holds too much unfinished data, alignment has to be a power of two
+  bool allocate(VkDeviceSize size, VkDeviceSize alignment, Region &region);
+  // Position after the latest allocation, frees everything before it when passed to release
+  uint64_t getHead() const;
+  void release(uint64_t position);
+
+  VkDeviceSize getSize() const { return size; }
+  VkDeviceSize getUsedBytes() const;
+
+ private:
+  VvtDevice &device;
+  VkDeviceSize size;
+  VkBuffer buffer;
+  VvtAllocation memory;
+
+  mutable std::mutex mutex;
+  uint64_t head = 0;
+  uint64_t tail = 0;
+};
+
+}  // namespace vvt
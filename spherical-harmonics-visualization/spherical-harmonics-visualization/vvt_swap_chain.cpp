@@ -48,8 +48,7 @@ VvtSwapChain::~VvtSwapChain() {
 
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-    vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.destroyImage(depthImages[i], depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -1,4 +1,5 @@
 #include "vvt_texture.hpp"
+#include "vvt_profiler.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -8,6 +9,7 @@ namespace vvt {
 
     VvtTexture::VvtTexture(VvtDevice& device, const char* imagePath, VvtTextureType textureType) : device{ device } 
     {
+        VVT_PROFILE_FUNCTION();
         switch (textureType)
         {
         case TEXTURE_TYPE_STANDARD_2D:
@@ -29,8 +31,7 @@ namespace vvt {
     {
         vkDestroySampler(device.device(), textureSampler, nullptr);
         vkDestroyImageView(device.device(), textureImageView, nullptr);
-        vkDestroyImage(device.device(), textureImage, nullptr);
-        vkFreeMemory(device.device(), textureImageMemory, nullptr);
+        device.destroyImage(textureImage, textureImageMemory);
     }
 
 	void VvtTexture::createTextureImage(const char * imagePath)
@@ -44,18 +45,6 @@ namespace vvt {
             throw std::runtime_error("Failed to load texture image!");
         }
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-
-        device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(device.device(), stagingBufferMemory);
-
-        stbi_image_free(pixels);
-
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -73,14 +62,10 @@ namespace vvt {
         imageInfo.flags = 0; // Optional
 
         device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
-        // Transition to layout that is efficient for the image to be written to
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, 1);
-        device.copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-        // Transition to layout that is efficient for shader to read from
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, 1);
-
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+
+        // The upload manager copies the pixels into its staging memory and leaves the image in shader read layout
+        device.getUploadManager().uploadImage(textureImage, pixels, imageSize, { getImageCopyRegion(texWidth, texHeight) }, 1, 1);
+        stbi_image_free(pixels);
 	}
 
     void VvtTexture::setupCubeMap(const char* imagePath, VkFormat format)
@@ -99,23 +84,6 @@ namespace vvt {
         ktx_size_t ktxTextureSize = ktxTexture_GetDataSize(ktxTexture);
 
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingMemory;
-
-        device.createBuffer(ktxTextureSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
-
-
-        VkMemoryRequirements memReqs;
-        vkGetBufferMemoryRequirements(device.device(), stagingBuffer, &memReqs);
-
-        // Copy texture data into staging buffer
-        uint8_t* data;
-        if (vkMapMemory(device.device(), stagingMemory, 0, memReqs.size, 0, (void**)&data) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to map staging buffer memory!");
-        }
-        memcpy(data, ktxTextureData, ktxTextureSize);
-        vkUnmapMemory(device.device(), stagingMemory);
-
         // Create optimal tiled target image
         VkImageCreateInfo imageCreateInfo{};
         imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -135,9 +103,6 @@ namespace vvt {
 
         device.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
 
-
-        VkCommandBuffer copyCmd = device.beginSingleTimeCommands();
-
         // Setup buffer copy regions for each face including all of its miplevels
         std::vector<VkBufferImageCopy> bufferCopyRegions;
         uint32_t offset = 0;
@@ -163,30 +128,8 @@ namespace vvt {
             }
         }
 
-        // Image barrier for optimal image (target)
-        // Set initial layout for all array layers (faces) of the optimal (target) tiled texture
-        VkImageSubresourceRange subresourceRange = {};
-        subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        subresourceRange.baseMipLevel = 0;
-        subresourceRange.levelCount = mipLevels;
-        subresourceRange.layerCount = 6;
-
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, 6);
-
-        // Copy the cube map faces from the staging buffer to the optimal tiled image
-        vkCmdCopyBufferToImage(
-            copyCmd,
-            stagingBuffer,
-            textureImage,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            static_cast<uint32_t>(bufferCopyRegions.size()),
-            bufferCopyRegions.data()
-        );
-
-        // Change texture image layout to shader read after all faces have been copied
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels, 6);
-
-        device.endSingleTimeCommands(copyCmd);
+        // Copy the cube map faces, the image is in shader read layout once the upload batch has executed
+        device.getUploadManager().uploadImage(textureImage, ktxTextureData, ktxTextureSize, bufferCopyRegions, mipLevels, 6);
 
         VkPhysicalDeviceProperties properties{};
         vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
@@ -230,12 +173,26 @@ namespace vvt {
             throw std::runtime_error("failed to create cubemap texture image view!");
         }
 
-        // Clean up staging resources
-        vkFreeMemory(device.device(), stagingMemory, nullptr);
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
         ktxTexture_Destroy(ktxTexture);
     }
 
+    VkBufferImageCopy VvtTexture::getImageCopyRegion(int texWidth, int texHeight)
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1 };
+        return region;
+    }
+
     void VvtTexture::createTextureImageView()
     {
         textureImageView = device.createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_VIEW_TYPE_2D, 1);
@@ -252,18 +209,6 @@ namespace vvt {
             throw std::runtime_error("Failed to load texture image!");
         }
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-
-        device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-        void* data;
-        vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(device.device(), stagingBufferMemory);
-
-        stbi_image_free(pixels);
-
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -281,14 +226,9 @@ namespace vvt {
         imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 
         device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
-        // Transition to layout that is efficient for the image to be written to
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, 6);
-        device.copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-        // Transition to layout that is efficient for shader to read from
-        device.transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, 6);
-
-        vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-        vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+
+        device.getUploadManager().uploadImage(textureImage, pixels, imageSize, { getImageCopyRegion(texWidth, texHeight) }, 1, 6);
+        stbi_image_free(pixels);
     }
 
 
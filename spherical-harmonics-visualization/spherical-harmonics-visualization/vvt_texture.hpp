@@ -26,6 +26,9 @@ namespace vvt {
 		VkDescriptorImageInfo descriptorInfo();
 
 	private:
+		// Single layer, single mip level copy of a tightly packed image
+		static VkBufferImageCopy getImageCopyRegion(int texWidth, int texHeight);
+
 		VvtDevice& device;
 
 		uint32_t width;
@@ -34,7 +37,7 @@ namespace vvt {
 
 		VkImage textureImage;
 		VkImageView textureImageView;
-		VkDeviceMemory textureImageMemory;
+		VvtAllocation textureImageMemory;
 		VkSampler textureSampler;
 	};
 }
@@ -0,0 +1,135 @@
+#include "vvt_thread_pool.hpp"
+#include "vvt_profiler.hpp"
+
+// std
+#include <cassert>
+
+namespace vvt {
+
+	namespace {
+		// Set for worker threads, so nested submits and getCurrentWorkerIndex know which queue belongs to them
+		thread_local const VvtThreadPool* currentPool = nullptr;
+		thread_local int currentWorkerIndex = -1;
+	}
+
+	VvtThreadPool::VvtThreadPool(uint32_t threadCount)
+	{
+		assert(threadCount > 0 && "A thread pool needs at least one worker thread!");
+
+		queues.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			queues.push_back(std::make_unique<WorkerQueue>());
+		}
+
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back([this, i]() { workerLoop(i); });
+		}
+	}
+
+	VvtThreadPool::~VvtThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t VvtThreadPool::defaultThreadCount()
+	{
+		// hardware_concurrency may return 0 if the value is not computable
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 0 ? hardwareThreads : 1;
+	}
+
+	int VvtThreadPool::getCurrentWorkerIndex() const
+	{
+		return currentPool == this ? currentWorkerIndex : -1;
+	}
+
+	void VvtThreadPool::push(std::function<void()> task)
+	{
+		int workerIndex = getCurrentWorkerIndex();
+		uint32_t queueIndex = workerIndex >= 0 ? static_cast<uint32_t>(workerIndex) : nextQueue++ % static_cast<uint32_t>(queues.size());
+
+		// Counted before it is queued, so the count never drops below the queued tasks while workers take them
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			pendingTasks++;
+		}
+		{
+			std::lock_guard<std::mutex> lock{ queues[queueIndex]->mutex };
+			queues[queueIndex]->tasks.push_back(std::move(task));
+		}
+		taskAvailable.notify_one();
+	}
+
+	bool VvtThreadPool::tryPop(uint32_t workerIndex, std::function<void()>& task)
+	{
+		// Own queue from the back, it most likely still has the task's data in cache
+		{
+			WorkerQueue& queue = *queues[workerIndex];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				return true;
+			}
+		}
+
+		// Steal from the front of the others, starting with the next worker to spread the thieves
+		uint32_t queueCount = static_cast<uint32_t>(queues.size());
+		for (uint32_t offset = 1; offset < queueCount; offset++)
+		{
+			WorkerQueue& queue = *queues[(workerIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void VvtThreadPool::workerLoop(uint32_t workerIndex)
+	{
+		VVT_PROFILE_THREAD_NAME("Worker");
+		currentPool = this;
+		currentWorkerIndex = static_cast<int>(workerIndex);
+
+		while (true)
+		{
+			std::function<void()> task;
+			if (tryPop(workerIndex, task))
+			{
+				{
+					std::lock_guard<std::mutex> lock{ sleepMutex };
+					pendingTasks--;
+				}
+				VVT_PROFILE_SCOPE("VvtThreadPool task");
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{ sleepMutex };
+			taskAvailable.wait(lock, [this]() { return stopping || pendingTasks > 0; });
+
+			// Remaining tasks are still executed before the pool shuts down
+			if (stopping && pendingTasks == 0)
+			{
+				return;
+			}
+		}
+	}
+}
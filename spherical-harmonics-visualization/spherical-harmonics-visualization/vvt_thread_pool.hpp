@@ -0,0 +1,68 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vvt {
+
+	/*
+	* Fixed size pool of worker threads with one task queue per worker. Tasks submitted from outside the pool are
+	* distributed round robin, tasks submitted by a worker go to its own queue. Workers take their newest task first
+	* and steal the oldest task of another worker when their own queue is empty.
+	*/
+	class VvtThreadPool
+	{
+	public:
+		explicit VvtThreadPool(uint32_t threadCount = defaultThreadCount());
+		~VvtThreadPool();
+
+		VvtThreadPool(const VvtThreadPool&) = delete;
+		VvtThreadPool& operator=(const VvtThreadPool&) = delete;
+
+		template <typename F>
+		auto submit(F&& task) -> std::future<decltype(task())>
+		{
+			using Result = decltype(task());
+			auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> result = packagedTask->get_future();
+			push([packagedTask]() { (*packagedTask)(); });
+			return result;
+		}
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+		// Index of the calling worker thread in [0, getThreadCount()), -1 if called from a thread outside this pool
+		int getCurrentWorkerIndex() const;
+
+		static uint32_t defaultThreadCount();
+
+	private:
+		struct WorkerQueue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		void push(std::function<void()> task);
+		bool tryPop(uint32_t workerIndex, std::function<void()>& task);
+		void workerLoop(uint32_t workerIndex);
+
+		std::vector<std::thread> workers;
+		std::vector<std::unique_ptr<WorkerQueue>> queues;
+		std::atomic<uint32_t> nextQueue{ 0 };
+
+		// Only guards sleeping and waking up, the queues have their own locks
+		std::mutex sleepMutex;
+		std::condition_variable taskAvailable;
+		size_t pendingTasks = 0;
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,449 @@
+#include "vvt_upload_manager.hpp"
+#include "vvt_device.hpp"
+#include "vvt_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace vvt {
+
+namespace {
+
+VkCommandPool createPool(VkDevice device, uint32_t queueFamily) {
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = queueFamily;
+  poolInfo.flags =
+      VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+  VkCommandPool pool;
+  if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload command pool!");
+  }
+  return pool;
+}
+
+VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool pool) {
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = pool;
+  allocInfo.commandBufferCount = 1;
+
+  VkCommandBuffer commandBuffer;
+  if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate upload command buffer!");
+  }
+  return commandBuffer;
+}
+
+void beginCommandBuffer(VkCommandBuffer commandBuffer) {
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording upload command buffer!");
+  }
+}
+
+}  // namespace
+
+VvtUploadManager::VvtUploadManager(VvtDevice &device) : device{device} {
+  QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
+  graphicsFamily = indices.graphicsFamily;
+  transferFamily = indices.transferFamily;
+
+  // Image copies need offsets aligned to the texel size, the optimal copy alignment is a power of two that covers it
+  stagingAlignment = std::max<VkDeviceSize>(device.properties.limits.optimalBufferCopyOffsetAlignment, 16);
+
+  transferPool = createPool(device.device(), transferFamily);
+  if (hasDedicatedTransferQueue()) {
+    acquirePool = createPool(device.device(), graphicsFamily);
+  }
+}
+
+VvtUploadManager::~VvtUploadManager() {
+  std::lock_guard<std::mutex> lock{mutex};
+
+  // Destinations of a batch that was never flushed may already be gone, so it is dropped instead of submitted
+  if (isRecording) {
+    vkEndCommandBuffer(recording.transferCommands);
+    destroyBatch(recording);
+  }
+
+  for (auto &batch : inFlight) {
+    vkWaitForFences(device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    destroyBatch(batch);
+  }
+  for (auto &batch : freeBatches) {
+    destroyBatch(batch);
+  }
+
+  vkDestroyCommandPool(device.device(), transferPool, nullptr);
+  if (acquirePool != VK_NULL_HANDLE) {
+    vkDestroyCommandPool(device.device(), acquirePool, nullptr);
+  }
+}
+
+VvtUploadManager::Batch &VvtUploadManager::getRecordingBatch() {
+  if (isRecording) {
+    return recording;
+  }
+
+  if (!freeBatches.empty()) {
+    recording = std::move(freeBatches.back());
+    freeBatches.pop_back();
+    vkResetFences(device.device(), 1, &recording.fence);
+    vkResetCommandBuffer(recording.transferCommands, 0);
+    if (recording.acquireCommands != VK_NULL_HANDLE) {
+      vkResetCommandBuffer(recording.acquireCommands, 0);
+    }
+  } else {
+    recording = Batch{};
+    recording.transferCommands = allocateCommandBuffer(device.device(), transferPool);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(device.device(), &fenceInfo, nullptr, &recording.fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload fence!");
+    }
+
+    if (hasDedicatedTransferQueue()) {
+      recording.acquireCommands = allocateCommandBuffer(device.device(), acquirePool);
+
+      VkSemaphoreCreateInfo semaphoreInfo{};
+      semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &recording.transferDone) !=
+          VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload semaphore!");
+      }
+    }
+  }
+
+  recording.ticket = nextTicket++;
+  beginCommandBuffer(recording.transferCommands);
+  isRecording = true;
+  return recording;
+}
+
+VvtUploadManager::StagingRange VvtUploadManager::stage(
+    Batch &batch, VkDeviceSize size, const StagingWriter &write) {
+  VvtStagingRing::Region region{};
+  if (device.getStagingRing().allocate(size, stagingAlignment, region)) {
+    write(region.mapped);
+    return {region.buffer, region.offset};
+  }
+
+  // Too large for the ring, or the GPU hasn't consumed enough of it yet
+  StagingBuffer staging{};
+  device.createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      staging.buffer,
+      staging.memory);
+
+  // Host visible allocations stay mapped
+  write(staging.memory.mapped);
+  batch.stagingBuffers.push_back(staging);
+  temporaryStagingCount++;
+  return {staging.buffer, 0};
+}
+
+VvtUploadTicket VvtUploadManager::uploadBuffer(
+    VkBuffer dstBuffer,
+    const void *data,
+    VkDeviceSize size,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess,
+    VkDeviceSize dstOffset) {
+  return uploadBuffer(
+      dstBuffer,
+      size,
+      [data, size](void *mapped) { memcpy(mapped, data, static_cast<size_t>(size)); },
+      dstStage,
+      dstAccess,
+      dstOffset);
+}
+
+VvtUploadTicket VvtUploadManager::uploadBuffer(
+    VkBuffer dstBuffer,
+    VkDeviceSize size,
+    const StagingWriter &write,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess,
+    VkDeviceSize dstOffset) {
+  assert(size > 0 && "Cannot upload an empty buffer range!");
+
+  // Ring ranges are released per batch, so they have to be taken in the order of the batches
+  std::lock_guard<std::mutex> lock{mutex};
+  collectCompleted();
+  Batch &batch = getRecordingBatch();
+  StagingRange staging = stage(batch, size, write);
+
+  VkBufferCopy copyRegion{};
+  copyRegion.srcOffset = staging.offset;
+  copyRegion.dstOffset = dstOffset;
+  copyRegion.size = size;
+  vkCmdCopyBuffer(batch.transferCommands, staging.buffer, dstBuffer, 1, &copyRegion);
+
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = dstAccess;
+  barrier.srcQueueFamilyIndex = hasDedicatedTransferQueue() ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = hasDedicatedTransferQueue() ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = dstBuffer;
+  barrier.offset = dstOffset;
+  barrier.size = size;
+  batch.bufferBarriers.push_back(barrier);
+  batch.dstStages |= dstStage;
+
+  return batch.ticket;
+}
+
+VvtUploadTicket VvtUploadManager::uploadImage(
+    VkImage image,
+    const void *data,
+    VkDeviceSize size,
+    const std::vector<VkBufferImageCopy> &regions,
+    uint32_t levelCount,
+    uint32_t layerCount) {
+  assert(!regions.empty() && "Cannot upload an image without copy regions!");
+
+  std::lock_guard<std::mutex> lock{mutex};
+  collectCompleted();
+  Batch &batch = getRecordingBatch();
+  StagingRange staging =
+      stage(batch, size, [data, size](void *mapped) { memcpy(mapped, data, static_cast<size_t>(size)); });
+
+  std::vector<VkBufferImageCopy> stagedRegions = regions;
+  for (auto &region : stagedRegions) {
+    region.bufferOffset += staging.offset;
+  }
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = levelCount;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = layerCount;
+  vkCmdPipelineBarrier(
+      batch.transferCommands,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0, nullptr,
+      0, nullptr,
+      1, &barrier);
+
+  vkCmdCopyBufferToImage(
+      batch.transferCommands,
+      staging.buffer,
+      image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(stagedRegions.size()),
+      stagedRegions.data());
+
+  // Images are only sampled in the fragment shader
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcQueueFamilyIndex = hasDedicatedTransferQueue() ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = hasDedicatedTransferQueue() ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+  batch.imageBarriers.push_back(barrier);
+  batch.dstStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+  return batch.ticket;
+}
+
+void VvtUploadManager::recordFinalBarriers(Batch &batch) {
+  uint32_t bufferBarrierCount = static_cast<uint32_t>(batch.bufferBarriers.size());
+  uint32_t imageBarrierCount = static_cast<uint32_t>(batch.imageBarriers.size());
+
+  if (!hasDedicatedTransferQueue()) {
+    vkCmdPipelineBarrier(
+        batch.transferCommands,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        batch.dstStages,
+        0,
+        0, nullptr,
+        bufferBarrierCount, batch.bufferBarriers.data(),
+        imageBarrierCount, batch.imageBarriers.data());
+    return;
+  }
+
+  // Release: the transfer queue knows nothing about the stages of the first use, so only the writes are made available
+  std::vector<VkBufferMemoryBarrier> bufferReleases = batch.bufferBarriers;
+  std::vector<VkImageMemoryBarrier> imageReleases = batch.imageBarriers;
+  for (auto &barrier : bufferReleases) {
+    barrier.dstAccessMask = 0;
+  }
+  for (auto &barrier : imageReleases) {
+    barrier.dstAccessMask = 0;
+  }
+  vkCmdPipelineBarrier(
+      batch.transferCommands,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0, nullptr,
+      bufferBarrierCount, bufferReleases.data(),
+      imageBarrierCount, imageReleases.data());
+
+  // Acquire on the graphics queue, ordered after the copies by the semaphore wait of its submission
+  for (auto &barrier : batch.bufferBarriers) {
+    barrier.srcAccessMask = 0;
+  }
+  for (auto &barrier : batch.imageBarriers) {
+    barrier.srcAccessMask = 0;
+  }
+  beginCommandBuffer(batch.acquireCommands);
+  vkCmdPipelineBarrier(
+      batch.acquireCommands,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      batch.dstStages,
+      0,
+      0, nullptr,
+      bufferBarrierCount, batch.bufferBarriers.data(),
+      imageBarrierCount, batch.imageBarriers.data());
+  if (vkEndCommandBuffer(batch.acquireCommands) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record upload acquire command buffer!");
+  }
+}
+
+void VvtUploadManager::submitBatch(Batch &batch) {
+  batch.stagingRingEnd = device.getStagingRing().getHead();
+  recordFinalBarriers(batch);
+  if (vkEndCommandBuffer(batch.transferCommands) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record upload command buffer!");
+  }
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &batch.transferCommands;
+
+  if (!hasDedicatedTransferQueue()) {
+    if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to submit upload command buffer!");
+    }
+    return;
+  }
+
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &batch.transferDone;
+  if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit upload command buffer!");
+  }
+
+  VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  VkSubmitInfo acquireInfo{};
+  acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  acquireInfo.waitSemaphoreCount = 1;
+  acquireInfo.pWaitSemaphores = &batch.transferDone;
+  acquireInfo.pWaitDstStageMask = &waitStage;
+  acquireInfo.commandBufferCount = 1;
+  acquireInfo.pCommandBuffers = &batch.acquireCommands;
+  if (vkQueueSubmit(device.graphicsQueue(), 1, &acquireInfo, batch.fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit upload acquire command buffer!");
+  }
+}
+
+VvtUploadTicket VvtUploadManager::flush() {
+  std::lock_guard<std::mutex> lock{mutex};
+  collectCompleted();
+  if (!isRecording) {
+    return nextTicket - 1;
+  }
+
+  VVT_PROFILE_FUNCTION();
+  submitBatch(recording);
+  submittedBatchCount++;
+  isRecording = false;
+
+  VvtUploadTicket ticket = recording.ticket;
+  inFlight.push_back(std::move(recording));
+  recording = Batch{};
+  return ticket;
+}
+
+bool VvtUploadManager::isComplete(VvtUploadTicket ticket) {
+  std::lock_guard<std::mutex> lock{mutex};
+  collectCompleted();
+  if (isRecording && ticket >= recording.ticket) {
+    return false;
+  }
+  return inFlight.empty() || inFlight.front().ticket > ticket;
+}
+
+void VvtUploadManager::wait(VvtUploadTicket ticket) {
+  bool needsFlush;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    needsFlush = isRecording && ticket >= recording.ticket;
+  }
+  if (needsFlush) {
+    flush();
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+  VVT_PROFILE_FUNCTION();
+  for (auto &batch : inFlight) {
+    if (batch.ticket > ticket) {
+      break;
+    }
+    vkWaitForFences(device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+  }
+  collectCompleted();
+}
+
+void VvtUploadManager::waitIdle() { wait(nextTicket); }
+
+void VvtUploadManager::collectCompleted() {
+  // Front to back, so a ticket counts as complete only once every batch before it has completed as well
+  while (!inFlight.empty() && vkGetFenceStatus(device.device(), inFlight.front().fence) == VK_SUCCESS) {
+    Batch &batch = inFlight.front();
+    for (auto &staging : batch.stagingBuffers) {
+      device.destroyBuffer(staging.buffer, staging.memory);
+    }
+    batch.stagingBuffers.clear();
+    device.getStagingRing().release(batch.stagingRingEnd);
+    batch.bufferBarriers.clear();
+    batch.imageBarriers.clear();
+    batch.dstStages = 0;
+
+    freeBatches.push_back(std::move(batch));
+    inFlight.pop_front();
+  }
+}
+
+void VvtUploadManager::destroyBatch(Batch &batch) {
+  for (auto &staging : batch.stagingBuffers) {
+    device.destroyBuffer(staging.buffer, staging.memory);
+  }
+  batch.stagingBuffers.clear();
+
+  vkFreeCommandBuffers(device.device(), transferPool, 1, &batch.transferCommands);
+  if (batch.acquireCommands != VK_NULL_HANDLE) {
+    vkFreeCommandBuffers(device.device(), acquirePool, 1, &batch.acquireCommands);
+  }
+  if (batch.transferDone != VK_NULL_HANDLE) {
+    vkDestroySemaphore(device.device(), batch.transferDone, nullptr);
+  }
+  vkDestroyFence(device.device(), batch.fence, nullptr);
+}
+
+}  // namespace vvt
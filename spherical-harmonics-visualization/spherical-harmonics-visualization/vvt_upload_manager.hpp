@@ -0,0 +1,134 @@
+#pragma once
+
+#include "vvt_allocator.hpp"
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace vvt {
+
+class VvtDevice;
+
+// Identifies the batch an upload was recorded into, batches complete in submission order
+using VvtUploadTicket = uint64_t;
+
+/*
+ * Collects buffer and image uploads into one command buffer per batch instead of a blocking submit per copy.
+ * Staging data goes into the staging ring of the device, whose range is released when the batch completed, so
+ * uploads don't create any Vulkan objects. Only data that doesn't fit gets a temporary staging buffer.
+ * Batches run on the transfer queue, which is a dedicated transfer family if the device has one. In that case
+ * ownership of every destination is released by the transfer queue and acquired by the graphics queue in a
+ * small second submission, which waits for the copies through a semaphore.
+ *
+ * Recording is thread safe. flush and wait submit to the device queues and have to be called from the thread
+ * that submits the frames. The renderer flushes before every frame, so uploads recorded while building a frame
+ * are visible to it without any CPU wait.
+ */
+class VvtUploadManager {
+ public:
+  VvtUploadManager(VvtDevice &device);
+  ~VvtUploadManager();
+
+  VvtUploadManager(const VvtUploadManager &) = delete;
+  VvtUploadManager &operator=(const VvtUploadManager &) = delete;
+
+  // The data is copied into a staging buffer right away, dstStage and dstAccess describe the first use
+  VvtUploadTicket uploadBuffer(
+      VkBuffer dstBuffer,
+      const void *data,
+      VkDeviceSize size,
+      VkPipelineStageFlags dstStage,
+      VkAccessFlags dstAccess,
+      VkDeviceSize dstOffset = 0);
+
+  // Writes the data straight into staging memory, for data that is converted on the way instead of copied.
+  // write gets size bytes of mapped memory and runs under the lock of the manager
+  using StagingWriter = std::function<void(void *mapped)>;
+  VvtUploadTicket uploadBuffer(
+      VkBuffer dstBuffer,
+      VkDeviceSize size,
+      const StagingWriter &write,
+      VkPipelineStageFlags dstStage,
+      VkAccessFlags dstAccess,
+      VkDeviceSize dstOffset = 0);
+
+  // Transitions the whole image from undefined to shader read only, regions offsets are relative to data
+  VvtUploadTicket uploadImage(
+      VkImage image,
+      const void *data,
+      VkDeviceSize size,
+      const std::vector<VkBufferImageCopy> &regions,
+      uint32_t levelCount,
+      uint32_t layerCount);
+
+  // Submits the recorded uploads without waiting, returns the ticket of the last submitted batch
+  VvtUploadTicket flush();
+  bool isComplete(VvtUploadTicket ticket);
+  // Flushes first if the ticket belongs to the batch that is still recording
+  void wait(VvtUploadTicket ticket);
+  void waitIdle();
+
+  bool hasDedicatedTransferQueue() const { return transferFamily != graphicsFamily; }
+  uint64_t getSubmittedBatchCount() const { return submittedBatchCount; }
+  uint64_t getTemporaryStagingCount() const { return temporaryStagingCount; }
+
+ private:
+  struct StagingBuffer {
+    VkBuffer buffer;
+    VvtAllocation memory;
+  };
+
+  struct StagingRange {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+  };
+
+  struct Batch {
+    VvtUploadTicket ticket = 0;
+    VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+    VkCommandBuffer acquireCommands = VK_NULL_HANDLE;  // Only with a dedicated transfer family
+    VkSemaphore transferDone = VK_NULL_HANDLE;  // Only with a dedicated transfer family
+    VkFence fence = VK_NULL_HANDLE;
+    std::vector<StagingBuffer> stagingBuffers;  // Temporary buffers for data that didn't fit into the ring
+    uint64_t stagingRingEnd = 0;  // Ring position after the last range of this batch
+
+    // Barriers to the first use, recorded at the end of the transfer commands or as acquire on the graphics queue
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    VkPipelineStageFlags dstStages = 0;
+  };
+
+  Batch &getRecordingBatch();
+  // Writes into the staging ring or, if it doesn't fit, into a temporary buffer of the batch
+  StagingRange stage(Batch &batch, VkDeviceSize size, const StagingWriter &write);
+  void recordFinalBarriers(Batch &batch);
+  void submitBatch(Batch &batch);
+  // Releases the staging buffers of completed batches and recycles their command buffers and sync objects
+  void collectCompleted();
+  void destroyBatch(Batch &batch);
+
+  VvtDevice &device;
+  uint32_t graphicsFamily;
+  uint32_t transferFamily;
+  VkCommandPool transferPool = VK_NULL_HANDLE;
+  VkCommandPool acquirePool = VK_NULL_HANDLE;
+  VkDeviceSize stagingAlignment;
+
+  std::mutex mutex;
+  Batch recording{};
+  bool isRecording = false;
+  std::deque<Batch> inFlight;
+  std::vector<Batch> freeBatches;
+  VvtUploadTicket nextTicket = 1;
+  uint64_t submittedBatchCount = 0;
+  uint64_t temporaryStagingCount = 0;
+};
+
+}  // namespace vvt
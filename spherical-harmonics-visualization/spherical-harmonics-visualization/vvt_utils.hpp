@@ -1,6 +1,8 @@
 #pragma once
 
 // std
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace vvt {
@@ -10,4 +12,15 @@ namespace vvt {
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
+
+	// FNV-1a, stable across runs and platforms, used for the keys and checksums of cache files
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
 }